@@ -0,0 +1,614 @@
+//
+// 调度器宏基准：skynet、令牌环与回环网络上的扇出/扇入回显，
+// 按执行器数(1 到全部核心)扫描，输出吞吐与 p50/p99/p999 延迟
+// (skynet 每轮只有一个样本，只输出每轮耗时的 mean/min/max)
+//
+// 用法:
+//   rco_macro_bench [--max-threads=N] [--runs=N] [--skynet=N] [--ring=N] [--hops=N]
+//                   [--conns=N] [--requests=N] [--filter=skynet,ring,echo] [--json=path]
+//                   [--placement=local|two-choices]
+//
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "rco.h"
+#include "cpc/channel.h"
+
+namespace {
+
+	struct Options {
+		uint16_t	max_threads = 0;
+		int			runs = 3;
+		int64_t		skynet = 1000000;	// skynet 叶子数(10 的幂)
+		int64_t		ring = 1000;		// 环上的协程数
+		int64_t		hops = 200000;		// 令牌传递次数
+		int64_t		conns = 64;			// 回显连接数
+		int64_t		requests = 2000;	// 每个连接的请求数
+		std::string filter = "skynet,ring,echo";
+		std::string json;
+		rco::Placement placement = rco::Placement::eLocal;
+	};
+
+	/**
+	 * @brief 一次测量的结果
+	 */
+	struct Result {
+		std::string name;
+		uint16_t	threads;
+		double		items_per_second;
+		double		p50_us;
+		double		p99_us;
+		double		p999_us;
+		bool		percentiles;	// 为 false 时样本只是每轮耗时，只有下面的统计有意义
+		double		mean_us;
+		double		min_us;
+		double		max_us;
+	};
+
+	uint64_t Now_ns() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	void Wait_for(const std::atomic<int64_t>& count, int64_t target) {
+		while(count.load(std::memory_order_acquire) < target) {
+			std::this_thread::yield();
+		}
+	}
+
+	/**
+	 * @brief 分位数(微秒)，samples 会被排序
+	 */
+	double Percentile_us(std::vector<uint64_t>& samples, double q) {
+		if(samples.empty()) {
+			return 0;
+		}
+		size_t index = std::min(samples.size() - 1, (size_t)(q * samples.size()));
+		std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+		return samples[index] / 1e3;
+	}
+
+	Result Make_result(const std::string& name, uint16_t threads, double items, double seconds,
+			std::vector<uint64_t>& samples) {
+		Result result;
+		result.name = name;
+		result.threads = threads;
+		result.items_per_second = items / seconds;
+		result.p50_us = Percentile_us(samples, 0.50);
+		result.p99_us = Percentile_us(samples, 0.99);
+		result.p999_us = Percentile_us(samples, 0.999);
+		result.percentiles = true;
+		result.mean_us = result.min_us = result.max_us = 0;
+		return result;
+	}
+
+	/**
+	 * @brief 样本为整轮耗时时的结果：轮数太少，分位数只是最小/最大值，改为 mean/min/max
+	 */
+	Result Make_run_result(const std::string& name, uint16_t threads, double items, double seconds,
+			const std::vector<uint64_t>& runs) {
+		Result result;
+		result.name = name;
+		result.threads = threads;
+		result.items_per_second = items / seconds;
+		result.p50_us = result.p99_us = result.p999_us = 0;
+		result.percentiles = false;
+		result.mean_us = result.min_us = result.max_us = 0;
+		if(!runs.empty()) {
+			uint64_t total = 0;
+			for(uint64_t ns : runs) {
+				total += ns;
+			}
+			result.mean_us = total / 1e3 / runs.size();
+			result.min_us = *std::min_element(runs.begin(), runs.end()) / 1e3;
+			result.max_us = *std::max_element(runs.begin(), runs.end()) / 1e3;
+		}
+		return result;
+	}
+
+	/**
+	 * @brief 单个接收者的邮箱：在通道之上，接收者为空时挂起，发送者唤醒
+	 *
+	 * 通道只有非阻塞的收发，这里用 CoPark/CoWake 补上等待
+	 */
+	template <typename T>
+		class Mailbox : public rco::Noncopyable {
+			public:
+				explicit Mailbox(size_t capacity)
+					: chan(capacity), waiter(nullptr), senders(0) {
+
+					}
+
+				/**
+				 * @brief 接收者在销毁前等待仍在通知的发送者离开
+				 */
+				~Mailbox() {
+					while(senders.load(std::memory_order_acquire)) {
+						rco::Processor::CoYield();
+					}
+				}
+
+				/**
+				 * @brief 发送，可在协程或普通线程中调用
+				 */
+				void send(T value) {
+					senders.fetch_add(1, std::memory_order_acq_rel);
+					while(!chan.try_send(value)) {
+						if(rco::Processor::CurrentTask()) {
+							rco::Processor::CoYield();
+						} else {
+							std::this_thread::yield();
+						}
+					}
+
+					rco::Task* task = waiter.exchange(Notified(), std::memory_order_acq_rel);
+					senders.fetch_sub(1, std::memory_order_release);
+					if(task && task != Notified()) {
+						rco::Processor::CoWake(task);
+					}
+				}
+
+				/**
+				 * @brief 接收，只能在有栈协程中调用
+				 */
+				void recv(T& value) {
+					rco::Task* self = rco::Processor::CurrentTask();
+					while(true) {
+						waiter.store(nullptr, std::memory_order_seq_cst);
+						if(chan.try_recv(value)) {
+							return;
+						}
+						rco::Processor::CoPark([this, self]{
+							// 挂起前已有发送，由自己唤醒；否则由之后的第一个发送者唤醒
+							rco::Task* expected = nullptr;
+							if(!waiter.compare_exchange_strong(expected, self, std::memory_order_acq_rel)) {
+								rco::Processor::CoWake(self);
+							}
+						}, "mailbox");
+					}
+				}
+
+			private:
+				RCO_STATIC rco::Task* Notified() {
+					return reinterpret_cast<rco::Task*>(uintptr_t(1));
+				}
+
+			private:
+				rco::Channel<T>			chan;
+				std::atomic<rco::Task*> waiter;
+				std::atomic<int>		senders;
+		};
+
+	/**
+	 * @brief skynet 节点：创建 10 个子节点并汇总它们的编号之和
+	 */
+	void Skynet(rco::Scheduler* sched, Mailbox<int64_t>* parent, int64_t num, int64_t size) {
+		if(size == 1) {
+			parent->send(num);
+			return;
+		}
+
+		Mailbox<int64_t> box(10);
+		int64_t child_size = size / 10;
+		for(int64_t i = 0; i < 10; ++i) {
+			int64_t child_num = num + i * child_size;
+			rco_go - rco_scheduler(sched) + [sched, &box, child_num, child_size]{
+				Skynet(sched, &box, child_num, child_size);
+			};
+		}
+
+		int64_t sum = 0;
+		for(int i = 0; i < 10; ++i) {
+			int64_t value = 0;
+			box.recv(value);
+			sum += value;
+		}
+		parent->send(sum);
+	}
+
+	/**
+	 * @brief skynet：以 10 叉树创建 size 个叶子协程并汇总，样本为每轮的耗时
+	 */
+	Result Bench_skynet(rco::Scheduler* sched, uint16_t threads, const Options& options) {
+		int64_t tasks = 0;
+		for(int64_t level = options.skynet; level >= 1; level /= 10) {
+			tasks += level;
+		}
+
+		std::vector<uint64_t> samples;
+		uint64_t total_ns = 0;
+		for(int run = 0; run < options.runs; ++run) {
+			std::atomic<int64_t> result(-1);
+			std::atomic<int64_t> done(0);
+
+			uint64_t begin = Now_ns();
+			rco_go - rco_scheduler(sched) + [&]{
+				Mailbox<int64_t> box(1);
+				int64_t size = options.skynet;
+				rco_go - rco_scheduler(sched) + [sched, &box, size]{
+					Skynet(sched, &box, 0, size);
+				};
+
+				int64_t sum = 0;
+				box.recv(sum);
+				result.store(sum, std::memory_order_relaxed);
+				done.fetch_add(1, std::memory_order_release);
+			};
+			Wait_for(done, 1);
+			uint64_t elapsed = Now_ns() - begin;
+
+			int64_t expected = options.skynet * (options.skynet - 1) / 2;
+			if(result.load(std::memory_order_relaxed) != expected) {
+				std::cerr << "skynet: wrong result " << result << ", expected " << expected << std::endl;
+				std::exit(1);
+			}
+			samples.push_back(elapsed);
+			total_ns += elapsed;
+		}
+		return Make_run_result("skynet", threads, (double)tasks * options.runs, total_ns / 1e9, samples);
+	}
+
+	struct Token {
+		uint64_t sent_ns;	// 发送时间
+		int64_t  remaining; // 剩余传递次数，不大于 0 时为退出令牌
+	};
+
+	/**
+	 * @brief 令牌环：ring 个协程通过通道依次传递令牌，延迟为每次传递(发送到对方收到)的耗时
+	 */
+	Result Bench_ring(rco::Scheduler* sched, uint16_t threads, const Options& options) {
+		const int64_t ring = std::max<int64_t>(options.ring, 2);
+		const int64_t hops = options.hops;
+
+		std::vector<uint64_t> samples(hops);
+		std::atomic<int64_t> sampled(0);
+		std::atomic<int64_t> done(0);
+
+		std::vector<std::unique_ptr<Mailbox<Token>>> boxes;
+		for(int64_t i = 0; i < ring; ++i) {
+			boxes.emplace_back(new Mailbox<Token>(1));
+		}
+
+		for(int64_t i = 0; i < ring; ++i) {
+			Mailbox<Token>* self = boxes[i].get();
+			Mailbox<Token>* next = boxes[(i + 1) % ring].get();
+			rco_go - rco_scheduler(sched) + [&, self, next]{
+				while(true) {
+					Token token;
+					self->recv(token);
+					if(token.remaining > 0) {
+						samples[sampled.fetch_add(1, std::memory_order_relaxed)] = Now_ns() - token.sent_ns;
+					} else if(token.remaining == 1 - ring) {
+						// 退出令牌已经传遍整个环
+						break;
+					}
+
+					int64_t remaining = token.remaining - 1;
+					next->send(Token{Now_ns(), remaining});
+					if(remaining <= 0) {
+						break;
+					}
+				}
+				done.fetch_add(1, std::memory_order_release);
+			};
+		}
+
+		uint64_t begin = Now_ns();
+		boxes[0]->send(Token{Now_ns(), hops});
+		Wait_for(done, ring);
+		uint64_t elapsed = Now_ns() - begin;
+
+		return Make_result("ring", threads, (double)hops, elapsed / 1e9, samples);
+	}
+
+	/**
+	 * @brief 在非阻塞套接字上读取一个 HTTP 消息(头部 + Content-Length 长度的正文)，没有数据时让出
+	 *
+	 * @return 对端关闭 ? false : true
+	 */
+	bool Read_message(int fd, std::string& buffer) {
+		buffer.clear();
+		size_t need = std::string::npos;
+		char chunk[1024];
+		while(buffer.size() < need) {
+			ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+			if(n > 0) {
+				buffer.append(chunk, n);
+				if(need == std::string::npos) {
+					size_t end = buffer.find("\r\n\r\n");
+					if(end != std::string::npos) {
+						size_t length = 0;
+						size_t pos = buffer.find("Content-Length: ");
+						if(pos != std::string::npos && pos < end) {
+							length = std::strtoul(buffer.c_str() + pos + 16, nullptr, 10);
+						}
+						need = end + 4 + length;
+					}
+				}
+			} else if(n == 0) {
+				return false;
+			} else if(errno == EAGAIN || errno == EWOULDBLOCK) {
+				rco::Processor::CoYield();
+			} else if(errno != EINTR) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool Write_all(int fd, const std::string& data) {
+		size_t sent = 0;
+		while(sent < data.size()) {
+			ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+			if(n > 0) {
+				sent += n;
+			} else if(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+				rco::Processor::CoYield();
+			} else if(n < 0 && errno == EINTR) {
+				continue;
+			} else {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void Set_nonblocking(int fd) {
+		fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+		int one = 1;
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+	}
+
+	/**
+	 * @brief 回环上的扇出/扇入回显：conns 个客户端协程并发发送类 HTTP 请求，
+	 * 服务端协程把请求作为正文返回，延迟为每个请求的往返耗时
+	 *
+	 * 没有 IO 多路复用，套接字为非阻塞，没有数据时让出
+	 */
+	Result Bench_echo(rco::Scheduler* sched, uint16_t threads, const Options& options) {
+		const int64_t conns = options.conns;
+		const int64_t requests = options.requests;
+
+		int listen_fd = ::socket(AF_INET, SOCK_STREAM, 0);
+		int one = 1;
+		setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+		sockaddr_in addr;
+		std::memset(&addr, 0, sizeof(addr));
+		addr.sin_family = AF_INET;
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		addr.sin_port = 0;
+		socklen_t addr_len = sizeof(addr);
+		if(::bind(listen_fd, (sockaddr*)&addr, sizeof(addr)) || ::listen(listen_fd, 1024)
+				|| ::getsockname(listen_fd, (sockaddr*)&addr, &addr_len)) {
+			std::cerr << "echo: listen failed: " << std::strerror(errno) << std::endl;
+			std::exit(1);
+		}
+		Set_nonblocking(listen_fd);
+
+		std::vector<uint64_t> samples(conns * requests);
+		std::atomic<int64_t> sampled(0);
+		std::atomic<int64_t> done(0);
+		std::atomic<int64_t> failed(0);
+
+		// 服务端：接受 conns 个连接，每个连接一个协程
+		rco_go - rco_scheduler(sched) + [&]{
+			for(int64_t accepted = 0; accepted < conns; ) {
+				int fd = ::accept(listen_fd, nullptr, nullptr);
+				if(fd < 0) {
+					rco::Processor::CoYield();
+					continue;
+				}
+				++accepted;
+				Set_nonblocking(fd);
+
+				rco_go - rco_scheduler(sched) - rco_stack_size(64 << 10) + [&, fd]{
+					std::string request;
+					while(Read_message(fd, request)) {
+						std::string response = "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nContent-Length: "
+							+ std::to_string(request.size()) + "\r\n\r\n" + request;
+						if(!Write_all(fd, response)) {
+							break;
+						}
+					}
+					::close(fd);
+					done.fetch_add(1, std::memory_order_release);
+				};
+			}
+			done.fetch_add(1, std::memory_order_release);
+		};
+
+		// 客户端：扇出 conns 个连接，每个连接依次发送 requests 个请求
+		uint64_t begin = Now_ns();
+		for(int64_t c = 0; c < conns; ++c) {
+			rco_go - rco_scheduler(sched) - rco_stack_size(64 << 10) + [&, c]{
+				int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+				// 回环上的连接由内核直接完成，阻塞连接不会等待服务端 accept
+				if(::connect(fd, (sockaddr*)&addr, sizeof(addr))) {
+					failed.fetch_add(1, std::memory_order_relaxed);
+					::close(fd);
+					done.fetch_add(1, std::memory_order_release);
+					return;
+				}
+				Set_nonblocking(fd);
+
+				std::string request = "GET /echo/" + std::to_string(c)
+					+ " HTTP/1.1\r\nHost: 127.0.0.1\r\nContent-Length: 0\r\n\r\n";
+				std::string response;
+				for(int64_t r = 0; r < requests; ++r) {
+					uint64_t sent = Now_ns();
+					if(!Write_all(fd, request) || !Read_message(fd, response)) {
+						failed.fetch_add(1, std::memory_order_relaxed);
+						break;
+					}
+					samples[sampled.fetch_add(1, std::memory_order_relaxed)] = Now_ns() - sent;
+				}
+				::close(fd);
+				done.fetch_add(1, std::memory_order_release);
+			};
+		}
+
+		// 扇入：等待客户端、服务端连接协程与接受协程
+		Wait_for(done, conns * 2 + 1);
+		uint64_t elapsed = Now_ns() - begin;
+		::close(listen_fd);
+
+		if(failed) {
+			std::cerr << "echo: " << failed << " connections failed" << std::endl;
+		}
+		samples.resize(sampled);
+		return Make_result("echo", threads, (double)samples.size(), elapsed / 1e9, samples);
+	}
+
+	bool Enabled(const Options& options, const std::string& name) {
+		return ("," + options.filter + ",").find("," + name + ",") != std::string::npos;
+	}
+
+	/**
+	 * @brief 执行器数 1, 2, 4, ... 直到 max
+	 */
+	std::vector<uint16_t> Thread_sweep(uint16_t max) {
+		std::vector<uint16_t> sweep;
+		for(uint16_t n = 1; n < max; n *= 2) {
+			sweep.push_back(n);
+		}
+		sweep.push_back(max);
+		return sweep;
+	}
+
+	bool Parse_options(int argc, char** argv, Options& options) {
+		for(int i = 1; i < argc; ++i) {
+			std::string arg = argv[i];
+			size_t eq = arg.find('=');
+			std::string key = arg.substr(0, eq);
+			std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+
+			if(key == "--max-threads") {
+				options.max_threads = std::atoi(value.c_str());
+			} else if(key == "--runs") {
+				options.runs = std::max(1, std::atoi(value.c_str()));
+			} else if(key == "--skynet") {
+				options.skynet = std::max(1ll, std::atoll(value.c_str()));
+			} else if(key == "--ring") {
+				options.ring = std::atoll(value.c_str());
+			} else if(key == "--hops") {
+				options.hops = std::max(1ll, std::atoll(value.c_str()));
+			} else if(key == "--conns") {
+				options.conns = std::max(1ll, std::atoll(value.c_str()));
+			} else if(key == "--requests") {
+				options.requests = std::max(1ll, std::atoll(value.c_str()));
+			} else if(key == "--filter") {
+				options.filter = value;
+			} else if(key == "--json") {
+				options.json = value;
+			} else if(key == "--placement" && (value == "local" || value == "two-choices")) {
+				options.placement = value == "local" ? rco::Placement::eLocal : rco::Placement::eTwoChoices;
+			} else {
+				std::cerr << "unknown option: " << arg << std::endl;
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * @brief 输出为与 Google Benchmark 相同结构的 JSON(context + benchmarks)
+	 */
+	std::string To_json(const std::vector<Result>& results) {
+		std::ostringstream os;
+		os << "{\n  \"context\": {\"executable\": \"rco_macro_bench\", \"num_cpus\": " << rco::Runtime::CPU_count()
+		   << "},\n  \"benchmarks\": [";
+		for(size_t i = 0; i < results.size(); ++i) {
+			const Result& r = results[i];
+			os << (i ? ",\n" : "\n")
+			   << "    {\"name\": \"" << r.name << "/threads:" << r.threads << "\""
+			   << ", \"threads\": " << r.threads
+			   << ", \"items_per_second\": " << r.items_per_second;
+			if(r.percentiles) {
+				os << ", \"p50_us\": " << r.p50_us
+				   << ", \"p99_us\": " << r.p99_us
+				   << ", \"p999_us\": " << r.p999_us << "}";
+			} else {
+				os << ", \"mean_us\": " << r.mean_us
+				   << ", \"min_us\": " << r.min_us
+				   << ", \"max_us\": " << r.max_us << "}";
+			}
+		}
+		os << "\n  ]\n}\n";
+		return os.str();
+	}
+}
+
+int main(int argc, char** argv) {
+	Options options;
+	if(!Parse_options(argc, argv, options)) {
+		return 2;
+	}
+	if(!options.max_threads) {
+		options.max_threads = rco::Runtime::CPU_count();
+	}
+
+	std::vector<Result> results;
+	for(uint16_t threads : Thread_sweep(options.max_threads)) {
+		rco::Sched_config config = rco::Runtime::Default_config();
+		config.placement = options.placement;
+		rco::Scheduler* sched = rco::Scheduler::Make(config);
+		sched->start(threads, threads, true);
+
+		std::vector<Result> round;
+		if(Enabled(options, "skynet")) {
+			round.push_back(Bench_skynet(sched, threads, options));
+		}
+		if(Enabled(options, "ring")) {
+			round.push_back(Bench_ring(sched, threads, options));
+		}
+		if(Enabled(options, "echo")) {
+			round.push_back(Bench_echo(sched, threads, options));
+		}
+		sched->shutdown(std::chrono::seconds(60));
+
+		for(const Result& r : round) {
+			char line[256];
+			if(r.percentiles) {
+				std::snprintf(line, sizeof(line), "%-8s threads=%-3u %12.0f items/s  p50=%9.1fus  p99=%9.1fus  p999=%9.1fus",
+						r.name.c_str(), r.threads, r.items_per_second, r.p50_us, r.p99_us, r.p999_us);
+			} else {
+				std::snprintf(line, sizeof(line), "%-8s threads=%-3u %12.0f items/s  mean=%8.1fus  min=%9.1fus  max=%10.1fus",
+						r.name.c_str(), r.threads, r.items_per_second, r.mean_us, r.min_us, r.max_us);
+			}
+			std::cout << line << std::endl;
+			results.push_back(r);
+		}
+	}
+
+	if(!options.json.empty()) {
+		std::ofstream ofs(options.json);
+		ofs << To_json(results);
+		if(!ofs) {
+			std::cerr << "failed to write " << options.json << std::endl;
+			return 1;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,408 @@
+//
+// 调度器微基准(Google Benchmark)：创建(逐个/批量)、切换、唤醒、通道与锁竞争的开销
+//
+// 输出 JSON:
+//   rco_bench --benchmark_format=json
+//   rco_bench --benchmark_out=rco_bench.json --benchmark_out_format=json
+//
+// 环境变量 RCO_BENCH_ITERATIONS 固定每个基准的迭代次数(用于回归比较，见 tools/perf)
+//
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <benchmark/benchmark.h>
+
+#include "rco.h"
+#include "cpc/channel.h"
+
+static uint64_t Now_ns() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief 在基准线程(不属于调度器)上等待计数到达目标值
+ */
+static void Wait_for(const std::atomic<int64_t>& count, int64_t target) {
+	while(count.load(std::memory_order_acquire) < target) {
+		std::this_thread::yield();
+	}
+}
+
+/**
+ * @brief 指定执行器数的调度器，在后台运行，同一执行器数的基准之间复用
+ *
+ * @param[in] procs 执行器数
+ *
+ * @return 调度器
+ */
+static rco::Scheduler* Bench_sched(uint16_t procs) {
+	RCO_STATIC std::mutex s_mutex;
+	RCO_STATIC std::map<uint16_t, rco::Scheduler*> s_scheds;
+
+	std::unique_lock<std::mutex> scope_lock(s_mutex);
+	rco::Scheduler*& sched = s_scheds[procs];
+	if(!sched) {
+		sched = rco::Scheduler::Make(rco::Runtime::Default_config());
+		sched->start(procs, procs, true);
+	}
+	return sched;
+}
+
+/**
+ * @brief 当前调度器各执行器移入的协程数之和
+ */
+static uint64_t Steals_in(rco::Scheduler* sched) {
+	uint64_t steals = 0;
+	for(const rco::Proc_stats& proc : sched->stats().processors) {
+		steals += proc.steals_in;
+	}
+	return steals;
+}
+
+/**
+ * @brief 设置了 RCO_BENCH_ITERATIONS 时固定迭代次数，否则按最短运行时间自动决定
+ */
+static void Bench_iterations(benchmark::internal::Benchmark* bench) {
+	const char* iterations = std::getenv("RCO_BENCH_ITERATIONS");
+	if(iterations && std::atoll(iterations) > 0) {
+		bench->Iterations(std::atoll(iterations));
+	}
+}
+
+/**
+ * @brief 创建并等待一批空协程执行完毕，每个协程的 创建+运行+回收 耗时
+ *
+ * 参数: 执行器数, 每轮协程数
+ */
+static void Bench_spawn_join(benchmark::State& state) {
+	rco::Scheduler* sched = Bench_sched(state.range(0));
+	const int64_t batch = state.range(1);
+
+	std::atomic<int64_t> done(0);
+	int64_t target = 0;
+	for(auto _ : state) {
+		target += batch;
+		for(int64_t i = 0; i < batch; ++i) {
+			rco_go - rco_scheduler(sched) + [&done]{
+				done.fetch_add(1, std::memory_order_release);
+			};
+		}
+		Wait_for(done, target);
+	}
+	state.SetItemsProcessed(state.iterations() * batch);
+}
+BENCHMARK(Bench_spawn_join)
+	->ArgNames({"procs", "batch"})
+	->Apply(Bench_iterations)
+	->Args({1, 1})
+	->Args({1, 1000})
+	->Args({2, 1000})
+	->Args({4, 1000})
+	->UseRealTime();
+
+/**
+ * @brief 与 Bench_spawn_join 相同，但通过 rco_batch 一次创建一轮协程(每个执行器加锁一次)
+ *
+ * 参数: 执行器数, 每轮协程数
+ */
+static void Bench_spawn_batch(benchmark::State& state) {
+	rco::Scheduler* sched = Bench_sched(state.range(0));
+	const int64_t batch = state.range(1);
+
+	std::atomic<int64_t> done(0);
+	int64_t target = 0;
+	for(auto _ : state) {
+		target += batch;
+		rco_go - rco_scheduler(sched) - rco_batch(batch) + [&done](std::size_t) {
+			done.fetch_add(1, std::memory_order_release);
+		};
+		Wait_for(done, target);
+	}
+	state.SetItemsProcessed(state.iterations() * batch);
+}
+BENCHMARK(Bench_spawn_batch)
+	->ArgNames({"procs", "batch"})
+	->Apply(Bench_iterations)
+	->Args({1, 1000})
+	->Args({2, 1000})
+	->Args({4, 1000})
+	->UseRealTime();
+
+/**
+ * @brief 协程让出的往返耗时：单个执行器上的协程反复让出，多于一个协程时协程之间轮转
+ *
+ * 参数: 协程数
+ */
+static void Bench_yield_round_trip(benchmark::State& state) {
+	static const int64_t YIELD_ROUNDS = 10000;
+
+	rco::Scheduler* sched = Bench_sched(1);
+	const int64_t tasks = state.range(0);
+
+	std::atomic<int64_t> done(0);
+	int64_t target = 0;
+	for(auto _ : state) {
+		target += tasks;
+		for(int64_t i = 0; i < tasks; ++i) {
+			rco_go - rco_scheduler(sched) + [&done]{
+				for(int64_t n = 0; n < YIELD_ROUNDS; ++n) {
+					rco::Processor::CoYield();
+				}
+				done.fetch_add(1, std::memory_order_release);
+			};
+		}
+		Wait_for(done, target);
+	}
+	state.SetItemsProcessed(state.iterations() * tasks * YIELD_ROUNDS);
+}
+BENCHMARK(Bench_yield_round_trip)
+	->ArgNames({"tasks"})
+	->Apply(Bench_iterations)
+	->Arg(1)
+	->Arg(2)
+	->Arg(8)
+	->UseRealTime();
+
+/**
+ * @brief 跨线程唤醒延迟：从其他线程 CoWake 到被挂起的协程重新运行
+ *
+ * 协程每轮挂起一次，基准线程等待其挂起后唤醒，每轮耗时为唤醒到协程恢复执行的时间
+ *
+ * 参数: 执行器数
+ */
+static void Bench_wakeup_latency(benchmark::State& state) {
+	rco::Scheduler* sched = Bench_sched(state.range(0));
+
+	std::atomic<rco::Task*> parked(nullptr);
+	std::atomic<uint64_t> woke_ns(0);
+	std::atomic<bool> stop(false);
+	std::atomic<int64_t> done(0);
+
+	rco_go - rco_scheduler(sched) + [&]{
+		rco::Task* self = rco::Processor::CurrentTask();
+		while(!stop.load(std::memory_order_acquire)) {
+			rco::Processor::CoPark([&parked, self]{
+				parked.store(self, std::memory_order_release);
+			}, "bench");
+			woke_ns.store(Now_ns(), std::memory_order_release);
+		}
+		done.fetch_add(1, std::memory_order_release);
+	};
+
+	auto take_parked = [&parked]{
+		rco::Task* task = nullptr;
+		while(!(task = parked.exchange(nullptr, std::memory_order_acquire))) {
+			std::this_thread::yield();
+		}
+		return task;
+	};
+
+	for(auto _ : state) {
+		rco::Task* task = take_parked();
+		uint64_t begin = Now_ns();
+		rco::Processor::CoWake(task);
+
+		uint64_t end = 0;
+		while(!(end = woke_ns.exchange(0, std::memory_order_acquire))) {
+			std::this_thread::yield();
+		}
+		state.SetIterationTime((end - begin) / 1e9);
+	}
+
+	stop.store(true, std::memory_order_release);
+	rco::Processor::CoWake(take_parked());
+	Wait_for(done, 1);
+}
+BENCHMARK(Bench_wakeup_latency)
+	->ArgNames({"procs"})
+	->Apply(Bench_iterations)
+	->Arg(1)
+	->Arg(2)
+	->UseManualTime();
+
+/**
+ * @brief 通道吞吐：生产者与消费者协程通过有界通道传递数据，满/空时让出
+ *
+ * 通道只有带缓冲区的实现，容量为 1 时最接近无缓冲通道
+ *
+ * 参数: 执行器数, 生产者数, 消费者数, 通道容量
+ */
+static void Bench_channel(benchmark::State& state) {
+	static const int64_t ITEMS = 100000;
+
+	rco::Scheduler* sched = Bench_sched(state.range(0));
+	const int64_t producers = state.range(1);
+	const int64_t consumers = state.range(2);
+	const int64_t capacity = state.range(3);
+
+	for(auto _ : state) {
+		rco::Channel<int64_t> chan(capacity);
+		std::atomic<int64_t> sent(0);
+		std::atomic<int64_t> received(0);
+		std::atomic<int64_t> done(0);
+
+		for(int64_t p = 0; p < producers; ++p) {
+			rco_go - rco_scheduler(sched) + [&]{
+				while(sent.fetch_add(1, std::memory_order_relaxed) < ITEMS) {
+					int64_t item = 1;
+					while(!chan.try_send(item)) {
+						rco::Processor::CoYield();
+					}
+				}
+				done.fetch_add(1, std::memory_order_release);
+			};
+		}
+		for(int64_t c = 0; c < consumers; ++c) {
+			rco_go - rco_scheduler(sched) + [&]{
+				int64_t item = 0;
+				while(received.load(std::memory_order_relaxed) < ITEMS) {
+					if(chan.try_recv(item)) {
+						received.fetch_add(item, std::memory_order_relaxed);
+					} else {
+						rco::Processor::CoYield();
+					}
+				}
+				done.fetch_add(1, std::memory_order_release);
+			};
+		}
+		Wait_for(done, producers + consumers);
+	}
+	state.SetItemsProcessed(state.iterations() * ITEMS);
+}
+BENCHMARK(Bench_channel)
+	->ArgNames({"procs", "producers", "consumers", "capacity"})
+	->Apply(Bench_iterations)
+	->Args({1, 1, 1, 1})
+	->Args({1, 1, 1, 1024})
+	->Args({2, 1, 1, 1024})
+	->Args({2, 4, 4, 1024})
+	->Args({4, 4, 4, 1024})
+	->UseRealTime();
+
+/**
+ * @brief 锁竞争：多个协程分布在多个执行器上，竞争同一把锁
+ *
+ * 参数: 执行器数, 协程数
+ */
+template <class Lock>
+static void Bench_lock_contention(benchmark::State& state) {
+	static const int64_t LOCK_ROUNDS = 10000;
+
+	rco::Scheduler* sched = Bench_sched(state.range(0));
+	const int64_t tasks = state.range(1);
+
+	Lock lock;
+	uint64_t shared = 0;
+	std::atomic<int64_t> done(0);
+	int64_t target = 0;
+	for(auto _ : state) {
+		target += tasks;
+		for(int64_t i = 0; i < tasks; ++i) {
+			rco_go - rco_scheduler(sched) + [&]{
+				for(int64_t n = 0; n < LOCK_ROUNDS; ++n) {
+					std::unique_lock<Lock> scope_lock(lock);
+					++shared;
+				}
+				done.fetch_add(1, std::memory_order_release);
+			};
+		}
+		Wait_for(done, target);
+	}
+	benchmark::DoNotOptimize(shared);
+	state.SetItemsProcessed(state.iterations() * tasks * LOCK_ROUNDS);
+}
+BENCHMARK_TEMPLATE(Bench_lock_contention, rco::Spin_lock)
+	->ArgNames({"procs", "tasks"})
+	->Apply(Bench_iterations)
+	->Args({1, 8})
+	->Args({2, 8})
+	->Args({4, 8})
+	->UseRealTime();
+BENCHMARK_TEMPLATE(Bench_lock_contention, std::mutex)
+	->ArgNames({"procs", "tasks"})
+	->Apply(Bench_iterations)
+	->Args({1, 8})
+	->Args({2, 8})
+	->Args({4, 8})
+	->UseRealTime();
+
+/**
+ * @brief 负载不均衡的恢复时间：在一个执行器上创建全部协程，统计其他执行器开始分担的时间
+ *
+ * 每轮耗时为全部协程执行完毕的时间；recovery_us 为创建完毕到每个执行器都运行过协程的平均时间，
+ * steals 为每轮负载均衡移入的协程数
+ *
+ * 参数: 执行器数, 协程数
+ */
+static void Bench_load_imbalance(benchmark::State& state) {
+	static const int64_t WORK_ROUNDS = 20000;
+
+	const uint16_t procs = state.range(0);
+	const int64_t tasks = state.range(1);
+	rco::Scheduler* sched = Bench_sched(procs);
+
+	double recovery_us = 0;
+	uint64_t steals = Steals_in(sched);
+	for(auto _ : state) {
+		std::unique_ptr<std::atomic<uint64_t>[]> first_run(new std::atomic<uint64_t>[procs]);
+		for(uint16_t i = 0; i < procs; ++i) {
+			first_run[i] = 0;
+		}
+		std::atomic<uint64_t> spawned_ns(0);
+		std::atomic<int64_t> done(0);
+
+		// 在协程内创建，全部进入同一个执行器
+		rco_go - rco_scheduler(sched) + [&]{
+			for(int64_t i = 0; i < tasks; ++i) {
+				rco_go - rco_scheduler(sched) + [&]{
+					uint64_t expected = 0;
+					first_run[rco::Processor::CurrentProcessor()->id() % procs]
+						.compare_exchange_strong(expected, Now_ns(), std::memory_order_relaxed);
+
+					uint64_t sum = 0;
+					for(int64_t n = 0; n < WORK_ROUNDS; ++n) {
+						benchmark::DoNotOptimize(sum += n);
+					}
+					done.fetch_add(1, std::memory_order_release);
+				};
+			}
+			spawned_ns.store(Now_ns(), std::memory_order_release);
+		};
+		Wait_for(done, tasks);
+
+		uint64_t recovered = spawned_ns.load(std::memory_order_acquire);
+		for(uint16_t i = 0; i < procs; ++i) {
+			uint64_t first = first_run[i].load(std::memory_order_relaxed);
+			if(!first) {
+				// 该执行器一直没有分担到协程
+				recovered = Now_ns();
+				break;
+			}
+			if(first > recovered) {
+				recovered = first;
+			}
+		}
+		recovery_us += (recovered - spawned_ns.load(std::memory_order_relaxed)) / 1e3;
+	}
+
+	state.counters["recovery_us"] = benchmark::Counter(recovery_us, benchmark::Counter::kAvgIterations);
+	state.counters["steals"] = benchmark::Counter(Steals_in(sched) - steals, benchmark::Counter::kAvgIterations);
+	state.SetItemsProcessed(state.iterations() * tasks);
+}
+BENCHMARK(Bench_load_imbalance)
+	->ArgNames({"procs", "tasks"})
+	->Apply(Bench_iterations)
+	->Args({2, 1000})
+	->Args({4, 1000})
+	->UseRealTime()
+	->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,105 @@
+//
+// 上下文切换微基准：输出每次切换的耗时(纳秒)
+//
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+
+#include "rco.h"
+
+static const uint64_t SWITCH_ROUNDS = 10000000;
+static const uint64_t YIELD_ROUNDS = 2000000;
+
+static rco::core::Context s_main_ctx;
+static rco::core::Context s_co_ctx;
+
+static void Ping(void*) {
+	while(true) {
+		rco::core::switch_context(&s_co_ctx, &s_main_ctx);
+	}
+}
+
+static double Elapsed_ns(std::chrono::steady_clock::time_point begin) {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now() - begin).count();
+}
+
+/**
+ * @brief 裸上下文切换：线程栈与协程栈之间来回切换
+ */
+static void Bench_jump() {
+	s_co_ctx.stack_size = 64 * 1024;
+	s_co_ctx.stack_ptr = malloc(s_co_ctx.stack_size);
+	rco::core::rco_make_context(&s_co_ctx, &Ping, nullptr);
+
+	// 预热
+	for(uint64_t i = 0; i < 1000; ++i) {
+		rco::core::switch_context(&s_main_ctx, &s_co_ctx);
+	}
+
+	auto begin = std::chrono::steady_clock::now();
+	for(uint64_t i = 0; i < SWITCH_ROUNDS; ++i) {
+		rco::core::switch_context(&s_main_ctx, &s_co_ctx);
+	}
+	double ns = Elapsed_ns(begin);
+
+	// 每轮两次切换
+	std::cout << "context jump:  " << ns / (SWITCH_ROUNDS * 2) << " ns/switch" << std::endl;
+
+	free(s_co_ctx.stack_ptr);
+}
+
+/**
+ * @brief 协程让出：单个执行器上的协程反复让出，包括调度开销
+ *
+ * @param[in] task_count 协程数，多于一个时协程之间直接切换
+ */
+static void Bench_yield(int task_count) {
+	rco::Sched_config config = rco::Runtime::Default_config();
+	rco::Scheduler* sched = rco::Scheduler::Make(config);
+
+	for(int i = 0; i < task_count; ++i) {
+		rco_go - rco_scheduler(sched) + []{
+			for(uint64_t i = 0; i < YIELD_ROUNDS; ++i) {
+				rco::Processor::CoYield();
+			}
+		};
+	}
+
+	auto begin = std::chrono::steady_clock::now();
+	sched->start(1, 1, true);
+	sched->shutdown(std::chrono::seconds(60));
+	double ns = Elapsed_ns(begin);
+
+	std::cout << "task yield x" << task_count << ": " << ns / (YIELD_ROUNDS * task_count) << " ns/yield" << std::endl;
+}
+
+// 当前架构，用于区分不同平台的结果
+#if defined(__x86_64__)
+#define BENCH_ARCH "x86_64"
+#elif defined(__i386__)
+#define BENCH_ARCH "i386"
+#elif defined(__aarch64__)
+#define BENCH_ARCH "aarch64"
+#elif defined(__riscv)
+#define BENCH_ARCH "riscv64"
+#endif
+
+#if defined(RCO_CONTEXT_UCONTEXT)
+#define BENCH_BACKEND "ucontext"
+#elif defined(RCO_CONTEXT_FCONTEXT)
+#define BENCH_BACKEND "fcontext"
+#else
+#define BENCH_BACKEND "asm"
+#endif
+
+int main() {
+	std::cout << "arch: " << BENCH_ARCH << ", backend: " << BENCH_BACKEND << std::endl;
+	Bench_jump();
+	Bench_yield(1);
+	Bench_yield(2);
+	Bench_yield(8);
+	return 0;
+}
@@ -4,6 +4,7 @@
 #define RCO_INLINE    inline
 #define RCO_NOEXCEPT  noexcept 
 #define RCO_CONSTEXPR constexpr
+#define RCO_NOINLINE  __attribute__((noinline))
 
 #define aco_likely(x) (__builtin_expect(!!(x), 1))
 
@@ -11,6 +12,9 @@
 
 #define RCO_CAS
 
+// 抢占信号
+#define RCO_PREEMPT_SIGNAL SIGURG
+
 #if defined(__linux__)
 
 	#define RCO_PLATFORM_LINUX
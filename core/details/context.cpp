@@ -1,32 +1,54 @@
+// 汇编后端(RCO_CONTEXT_BACKEND=asm)，切换见 core/asm/context_jump.S
+
 #include "context.h"
 
 #include <assert.h>
 #include <cstring>
 
-#define REG_IDX_SP 0
-#define REG_IDX_AX 2
-#define REG_IDX_DI 4 
-
-//----- --------
+//-------------
+// 切出后栈上保存的寄存器(由低地址到高地址)
+//
 // 32 bit
-// | regs[0]: esp |
-// | regs[1]: ebp |
-// | regs[2]: eax |
-// | regs[3]: ebx |
-// | regs[4]: edi |
+// | fpu: mxcsr | fpu: x87 cw | edi | esi | ebx | ebp | ret |
 //
-//-------------
 // 64 bit
-// | regs[0]: rsp |
-// | regs[1]: rbp |
-// | regs[2]: rax |
-// | regs[3]: rbx |
-// | regs[4]: rdi |
-// | regs[5]: r12 |
-// | regs[6]: r13 |
-// | regs[7]: r14 |
-// | regs[8]: r15 |
+// | fpu: mxcsr, x87 cw | r15 | r14 | r13 | r12 | rbx | rbp | ret |
+//
+// aarch64
+// | d8 - d15 | x19 - x28 | x29(fp) | x30(lr) | fpcr | pad |
+//
+// riscv64
+// | s0 - s11 | ra | fs0 - fs11 | fcsr |
+//
+// 首次切入时帧指针(ebp/rbp/x29/s0)为0，ret/lr/ra 为 rco_context_entry，
+// 入口函数与参数分别放在 ebx/esi、r13/r12、x20/x19、s1/s2 中，由 rco_context_entry 调用
+//-------------
 
+#if defined(__i386__)
+#define SAVED_SLOTS		7
+#define SLOT_ARG		3
+#define SLOT_PFN		4
+#define SLOT_FP			5
+#define SLOT_RET		6
+#elif defined(__x86_64__)
+#define SAVED_SLOTS		8
+#define SLOT_ARG		4
+#define SLOT_PFN		3
+#define SLOT_FP			6
+#define SLOT_RET		7
+#elif defined(__aarch64__)
+#define SAVED_SLOTS		22
+#define SLOT_ARG		8
+#define SLOT_PFN		9
+#define SLOT_FP			18
+#define SLOT_RET		19
+#elif defined(__riscv)
+#define SAVED_SLOTS		26
+#define SLOT_ARG		2
+#define SLOT_PFN		1
+#define SLOT_FP			0
+#define SLOT_RET		12
+#endif
 
 void rco::core::rco_make_context(Context* ctx,  Context::rco_func pfn, void* arg) {
 	assert(ctx);
@@ -35,22 +57,39 @@ void rco::core::rco_make_context(Context* ctx,  Context::rco_func pfn, void* arg
 		return;
 	}
 
-	std::memset(ctx->regs, 0, sizeof(ctx->regs));
+	// 栈顶对齐，并预留16字节，入口函数以对齐的栈开始执行
+	char* sp = (char*)ctx->stack_ptr + ctx->stack_size;
+	sp = (char*)((uintptr_t)sp & ~(uintptr_t)15) - 16;
 
-	char* sp = nullptr;
-#if defined(__i386__)
-	sp = (char*)ctx->stack_ptr + ctx->stack_size - (sizeof(void*) << 1);
-#elif defined(__x86_64__)
-	sp = (char*)ctx->stack_ptr + ctx->stack_size;
+	// 只初始化保存寄存器的区域，不清空整个栈
+	void** slots = (void**)sp - SAVED_SLOTS;
+	std::memset(slots, 0, sizeof(void*) * SAVED_SLOTS);
+
+#if defined(__i386__) || defined(__x86_64__)
+	// 默认浮点环境: MXCSR 屏蔽所有异常，x87 双扩展精度
+	uint32_t* fpu = (uint32_t*)slots;
+	fpu[0] = 0x1F80;
+	fpu[1] = 0x037F;
 #endif
-	sp = (char*)((unsigned long)sp & -16LL);
 
-	ctx->regs[REG_IDX_SP] = sp;
+	ctx->pfn = pfn;
+	ctx->arg = arg;
+	fiber_create(ctx);
 
-	void** ret = (void**)sp;
+	slots[SLOT_ARG] = ctx;
+	slots[SLOT_PFN] = (void*)&context_entry;
+	slots[SLOT_RET] = (void*)&rco_context_entry;
+
+	ctx->sp = slots;
+}
+
+bool rco::core::context_frame(const Context* ctx, void** pc, void** fp) {
+	if(!ctx->sp) {
+		return false;
+	}
 
-	*ret = (void*)pfn;
-	
-	ctx->regs[REG_IDX_AX] = *ret;
-	ctx->regs[REG_IDX_DI] = (void*)arg;
+	void* const* slots = (void* const*)ctx->sp;
+	*pc = slots[SLOT_RET];
+	*fp = slots[SLOT_FP];
+	return true;
 }
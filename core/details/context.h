@@ -3,29 +3,150 @@
 #include <cstring>
 #include <cstdint>
 
+#include "../../common/internal.h"
+
+// 上下文切换后端，由 CMake 选项 RCO_CONTEXT_BACKEND 选择，默认为汇编实现
+#if !defined(RCO_CONTEXT_ASM) && !defined(RCO_CONTEXT_UCONTEXT) && !defined(RCO_CONTEXT_FCONTEXT)
+	#define RCO_CONTEXT_ASM
+#endif
+
+#if defined(RCO_CONTEXT_UCONTEXT)
+	#include <ucontext.h>
+#endif
+
+// 开启 ASan/TSan 时，切换上下文需要通知 sanitizer
+#if defined(__SANITIZE_ADDRESS__)
+	#define RCO_ASAN
+#elif defined(__has_feature)
+	#if __has_feature(address_sanitizer)
+		#define RCO_ASAN
+	#endif
+#endif
+
+#if defined(__SANITIZE_THREAD__)
+	#define RCO_TSAN
+#elif defined(__has_feature)
+	#if __has_feature(thread_sanitizer)
+		#define RCO_TSAN
+	#endif
+#endif
+
+#if defined(RCO_ASAN) || defined(RCO_TSAN)
+	#define RCO_FIBER_ANNOTATION
+#endif
+
 namespace rco {
 	namespace core {
+		/**
+		 * @brief 协程上下文
+		 *
+		 * asm:		 切换时被调用者保存寄存器与浮点控制字压入当前栈，sp 记录栈顶
+		 * ucontext: 使用 swapcontext，可移植，但每次切换都会通过系统调用保存信号掩码
+		 * fcontext: 使用 Boost.Context 的 fcontext，sp 记录 fcontext_t
+		 */
 		struct Context {
 			typedef void(*rco_func)(void*);
-			
-			Context() {
-				std::memset(this, 0, sizeof(Context));
-			}
-
-#ifdef __i386__
-			void*  regs[5];
-#elif __x86_64__
-			void*  regs[9];
-#else
+
+			Context()
+				: sp(nullptr)
+				  , stack_ptr(nullptr)
+				  , stack_size(0)
+				  , pfn(nullptr)
+				  , arg(nullptr) {
+#if defined(RCO_FIBER_ANNOTATION)
+					  fake_stack = nullptr;
+					  fiber_bottom = nullptr;
+					  fiber_size = 0;
+					  tsan_fiber = nullptr;
+#endif
+				  }
+
+#if defined(RCO_CONTEXT_ASM) && !defined(__i386__) && !defined(__x86_64__) && !defined(__aarch64__) \
+	&& !(defined(__riscv) && __riscv_xlen == 64)
 	#error "platform no support yet"
 #endif
-			void* stack_ptr;
+// aarch64 / riscv64 的切换尚未在目标机器上验证(见 CMake 选项 RCO_EXPERIMENTAL_ARCH)
+#if defined(RCO_CONTEXT_ASM) && (defined(__aarch64__) || defined(__riscv)) && !defined(RCO_EXPERIMENTAL_ARCH)
+	#error "asm context switch on this platform is experimental, define RCO_EXPERIMENTAL_ARCH or use RCO_CONTEXT_UCONTEXT"
+#endif
+			void*  sp;			// 切出时的栈顶(保存的寄存器位于其上)
+			void*  stack_ptr;
 			size_t stack_size;
+
+			rco_func pfn;		// 入口函数
+			void*	 arg;		// 入口函数参数
+
+#if defined(RCO_CONTEXT_UCONTEXT)
+			ucontext_t uctx;
+#endif
+
+#if defined(RCO_FIBER_ANNOTATION)
+			void*		fake_stack;		// ASan 切出时保存的伪栈
+			const void* fiber_bottom;	// 线程栈的栈底(线程上下文首次切出时获取)
+			size_t		fiber_size;
+			void*		tsan_fiber;		// TSan fiber
+#endif
 		};
 
 		extern "C" {
+			/**
+			 * @brief 初始化上下文，首次切入时调用 pfn(arg)；stack_ptr 为空时表示线程自身的上下文
+			 */
 			void rco_make_context(Context* ctx,  Context::rco_func pfn, void* arg);
-			void rco_jump_context(Context*, Context*) asm("rco_jump_context");
+
+			/**
+			 * @brief 保存当前上下文到 from，并切换到 to(由后端实现)
+			 */
+			void rco_jump_context(Context* from, Context* to) asm("rco_jump_context");
+
+#if defined(RCO_CONTEXT_ASM)
+			void rco_context_entry() asm("rco_context_entry");
+#endif
+		}
+
+		/**
+		 * @brief 协程首次切入时执行：完成切换注解后调用入口函数，入口函数不能返回
+		 *
+		 * @param[in] ctx 上下文(Context*)
+		 */
+		void context_entry(void* ctx);
+
+		/**
+		 * @brief 获取已切出的上下文保存的返回地址与帧指针(用于回溯协程的调用栈)
+		 *
+		 * @param[in]  ctx 已切出的上下文
+		 * @param[out] pc  切出位置的返回地址
+		 * @param[out] fp  切出位置的帧指针
+		 *
+		 * @return 后端/平台支持并且上下文已保存 ? true : false
+		 */
+		bool context_frame(const Context* ctx, void** pc, void** fp);
+
+#if defined(RCO_FIBER_ANNOTATION)
+		// sanitizer 注解，不内联：协程恢复时可能已经在其他线程上
+		void fiber_create(Context* ctx);
+		void fiber_destroy(Context* ctx);
+		RCO_NOINLINE void fiber_before_switch(Context* from, Context* to);
+		RCO_NOINLINE void fiber_after_switch(Context* self);
+		RCO_NOINLINE void fiber_entry();
+#else
+		RCO_INLINE void fiber_create(Context*) {}
+		RCO_INLINE void fiber_destroy(Context*) {}
+		RCO_INLINE void fiber_before_switch(Context*, Context*) {}
+		RCO_INLINE void fiber_after_switch(Context*) {}
+		RCO_INLINE void fiber_entry() {}
+#endif
+
+		/**
+		 * @brief 切换上下文
+		 *
+		 * @param[in] from 当前上下文
+		 * @param[in] to   目标上下文
+		 */
+		RCO_INLINE void switch_context(Context* from, Context* to) {
+			fiber_before_switch(from, to);
+			rco_jump_context(from, to);
+			fiber_after_switch(from);
 		}
 
 	}
@@ -0,0 +1,64 @@
+// fcontext 后端(RCO_CONTEXT_BACKEND=fcontext)，使用 Boost.Context 的 make_fcontext/jump_fcontext
+
+#include "context.h"
+
+#include <boost/context/detail/fcontext.hpp>
+
+namespace fctx = boost::context::detail;
+
+/**
+ * @brief 首次切入：jump_fcontext 传入 {from, to}，记录 from 切出时的 fcontext
+ */
+RCO_STATIC void Fcontext_entry(fctx::transfer_t t) {
+	rco::core::Context** pair = static_cast<rco::core::Context**>(t.data);
+	pair[0]->sp = t.fctx;
+	rco::core::context_entry(pair[1]);
+}
+
+void rco::core::rco_make_context(Context* ctx, Context::rco_func pfn, void* arg) {
+	ctx->pfn = pfn;
+	ctx->arg = arg;
+
+	// 线程自身的上下文在切出时由 jump_fcontext 返回
+	if(!ctx->stack_ptr) {
+		return;
+	}
+
+	fiber_create(ctx);
+
+	void* top = static_cast<char*>(ctx->stack_ptr) + ctx->stack_size;
+	ctx->sp = fctx::make_fcontext(top, ctx->stack_size, &Fcontext_entry);
+}
+
+void rco::core::rco_jump_context(Context* from, Context* to) {
+	Context* pair[2] = { from, to };
+	fctx::transfer_t t = fctx::jump_fcontext(to->sp, pair);
+
+	// 切回：t.data 为切回方传入的 {from, to}，记录其切出时的 fcontext
+	static_cast<Context**>(t.data)[0]->sp = t.fctx;
+}
+
+bool rco::core::context_frame(const Context* ctx, void** pc, void** fp) {
+	if(!ctx->sp) {
+		return false;
+	}
+
+	// jump_fcontext 保存的寄存器布局(fcontext_t 指向的位置)
+	void* const* slots = (void* const*)ctx->sp;
+#if defined(__x86_64__)
+	// | mxcsr, x87 cw | r12 | r13 | r14 | r15 | rbx | rbp | rip |
+	*fp = slots[6];
+	*pc = slots[7];
+	return true;
+#elif defined(__aarch64__)
+	// | d8 - d15 | x19 - x28 | fp | lr | pc |
+	*fp = slots[18];
+	*pc = slots[20];
+	return true;
+#else
+	(void)slots;
+	(void)pc;
+	(void)fp;
+	return false;
+#endif
+}
@@ -0,0 +1,59 @@
+// ucontext 后端(RCO_CONTEXT_BACKEND=ucontext)，可移植但切换较慢
+
+#include "context.h"
+
+#include <assert.h>
+#include <cstdint>
+
+/**
+ * @brief makecontext 只能传递 int 参数，指针拆成高低两部分传递
+ */
+RCO_STATIC void Ucontext_entry(unsigned int hi, unsigned int lo) {
+	uintptr_t ptr = ((uintptr_t)hi << 16 << 16) | (uintptr_t)lo;
+	rco::core::context_entry((void*)ptr);
+}
+
+void rco::core::rco_make_context(Context* ctx, Context::rco_func pfn, void* arg) {
+	ctx->pfn = pfn;
+	ctx->arg = arg;
+
+	// 线程自身的上下文由 swapcontext 在切出时保存
+	if(!ctx->stack_ptr) {
+		return;
+	}
+
+	fiber_create(ctx);
+
+	int ret = getcontext(&ctx->uctx);
+	assert(ret == 0);
+	(void)ret;
+
+	ctx->uctx.uc_stack.ss_sp = ctx->stack_ptr;
+	ctx->uctx.uc_stack.ss_size = ctx->stack_size;
+	ctx->uctx.uc_link = nullptr;
+
+	uintptr_t ptr = (uintptr_t)ctx;
+	makecontext(&ctx->uctx, (void(*)())&Ucontext_entry, 2,
+			(unsigned int)(ptr >> 16 >> 16), (unsigned int)(ptr & 0xFFFFFFFFu));
+}
+
+void rco::core::rco_jump_context(Context* from, Context* to) {
+	swapcontext(&from->uctx, &to->uctx);
+}
+
+bool rco::core::context_frame(const Context* ctx, void** pc, void** fp) {
+#if defined(__linux__) && defined(__x86_64__)
+	*pc = (void*)ctx->uctx.uc_mcontext.gregs[REG_RIP];
+	*fp = (void*)ctx->uctx.uc_mcontext.gregs[REG_RBP];
+	return true;
+#elif defined(__linux__) && defined(__aarch64__)
+	*pc = (void*)ctx->uctx.uc_mcontext.pc;
+	*fp = (void*)ctx->uctx.uc_mcontext.regs[29];
+	return true;
+#else
+	(void)ctx;
+	(void)pc;
+	(void)fp;
+	return false;
+#endif
+}
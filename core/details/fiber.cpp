@@ -0,0 +1,85 @@
+#include "context.h"
+
+#include <cstdlib>
+
+#if defined(RCO_FIBER_ANNOTATION)
+#include <pthread.h>
+#endif
+
+#if defined(RCO_ASAN)
+#include <sanitizer/common_interface_defs.h>
+#endif
+
+#if defined(RCO_TSAN)
+#include <sanitizer/tsan_interface.h>
+#endif
+
+void rco::core::context_entry(void* arg) {
+	Context* ctx = static_cast<Context*>(arg);
+
+	fiber_entry();
+	ctx->pfn(ctx->arg);
+
+	// 入口函数返回后没有可以切换的上下文
+	abort();
+}
+
+#if defined(RCO_FIBER_ANNOTATION)
+
+void rco::core::fiber_create(Context* ctx) {
+#if defined(RCO_TSAN)
+	ctx->tsan_fiber = __tsan_create_fiber(0);
+#endif
+}
+
+void rco::core::fiber_destroy(Context* ctx) {
+#if defined(RCO_TSAN)
+	// 线程上下文使用线程自身的 fiber，不能销毁
+	if(ctx->stack_ptr && ctx->tsan_fiber) {
+		__tsan_destroy_fiber(ctx->tsan_fiber);
+		ctx->tsan_fiber = nullptr;
+	}
+#endif
+}
+
+void rco::core::fiber_before_switch(Context* from, Context* to) {
+	// 线程上下文首次切出，记录线程栈与线程的 fiber，切回时使用
+	if(!from->stack_ptr && !from->fiber_bottom) {
+		pthread_attr_t attr;
+		void*  bottom = nullptr;
+		size_t size = 0;
+		if(pthread_getattr_np(pthread_self(), &attr) == 0) {
+			pthread_attr_getstack(&attr, &bottom, &size);
+			pthread_attr_destroy(&attr);
+		}
+		from->fiber_bottom = bottom;
+		from->fiber_size = size;
+#if defined(RCO_TSAN)
+		from->tsan_fiber = __tsan_get_current_fiber();
+#endif
+	}
+
+#if defined(RCO_ASAN)
+	const void* bottom = to->stack_ptr ? to->stack_ptr : to->fiber_bottom;
+	size_t size = to->stack_ptr ? to->stack_size : to->fiber_size;
+	__sanitizer_start_switch_fiber(&from->fake_stack, bottom, size);
+#endif
+
+#if defined(RCO_TSAN)
+	__tsan_switch_to_fiber(to->tsan_fiber, 0);
+#endif
+}
+
+void rco::core::fiber_after_switch(Context* self) {
+#if defined(RCO_ASAN)
+	__sanitizer_finish_switch_fiber(self->fake_stack, nullptr, nullptr);
+#endif
+}
+
+void rco::core::fiber_entry() {
+#if defined(RCO_ASAN)
+	__sanitizer_finish_switch_fiber(nullptr, nullptr, nullptr);
+#endif
+}
+
+#endif
@@ -4,40 +4,78 @@
 //#include <jemalloc/jemalloc.h>
 
 #include <assert.h>
+#include <new>
 
-struct ContextIniter {
-	rco::RContext ctx;
-	ContextIniter()
-		: ctx(nullptr, nullptr,0) {
+rco::RContext::RContext(rctx_fn pfn, void* arg, size_t stack_size,
+		core::Stack_mode mode, size_t max_size, bool paint)
+	: pfn(pfn)
+	  , arg(arg)
+	  , stack_size(stack_size)
+	  , max_size(max_size)
+	  , mode(mode)
+	  , paint(paint) {
 
-		}
-};
+#if defined(RCO_ASAN)
+	// ASan 插桩后栈帧显著增大，放大协程栈避免误报栈溢出
+	this->stack_size *= 8;
+	this->max_size *= 8;
+#endif
 
-rco::RContext::RContext(rctx_fn pfn, void* arg, size_t stack_size) {
+	// 线程上下文(栈大小为0)使用线程自身的栈，不需要分配
+	if(!stack_size) {
+		core::rco_make_context(&ctx, pfn, arg);
+	}
+}
+
+rco::RContext::~RContext() {
+	release(nullptr);
+}
+
+void rco::RContext::acquire(core::Stack_cache* cache) {
+	assert(!ready());
+
+	bool ok = cache ? cache->acquire(stack, stack_size, mode, max_size)
+		: core::stack_alloc(stack, stack_size, mode, max_size);
+	if(!ok) {
+		throw std::bad_alloc();
+	}
 
-	ctx.stack_size = stack_size;
-	ctx.stack_ptr = (char*)malloc(stack_size);
+	ctx.stack_ptr = stack.bottom();
+	ctx.stack_size = stack.usable();
+
+	// 先填充标记再初始化上下文
+	if(paint) {
+		core::stack_paint(stack);
+	}
 
 	core::rco_make_context(&ctx, pfn, arg);
 }
 
-rco::RContext::~RContext() {
+void rco::RContext::release(core::Stack_cache* cache) {
+	if(!stack.base) {
+		return;
+	}
 
-}
+	core::fiber_destroy(&ctx);
 
-void rco::RContext::swap_out() {
-//	assert(&GetCtx().ctx == &ctx);
-	core::rco_jump_context(&ctx, &GetCtx().ctx);
+	// 归还协程栈
+	if(cache) {
+		cache->release(stack);
+	} else {
+		core::stack_free(stack);
+	}
+	ctx.stack_ptr = nullptr;
 }
 
-void rco::RContext::swap_in() {
-//	assert(&GetCtx().ctx == &ctx);
-	core::rco_jump_context(&GetCtx().ctx, &ctx);
-}
+size_t rco::RContext::backtrace(void** frames, size_t max) const {
+	void* pc = nullptr;
+	void* fp = nullptr;
+	if(!stack_size || !stack.base || !core::context_frame(&ctx, &pc, &fp)) {
+		return 0;
+	}
 
-rco::RContext& rco::RContext::GetCtx() {
-	RCO_STATIC thread_local ContextIniter s_tl_ctx_initer;
-//    RCO_STATIC thread_local core::Context s_tl_ctx;
-	return s_tl_ctx_initer.ctx;
+	// 只读取协程栈内的地址，回溯时协程可能正在其他线程上运行
+	uintptr_t low = ctx.sp ? (uintptr_t)ctx.sp : (uintptr_t)ctx.stack_ptr;
+	uintptr_t high = (uintptr_t)ctx.stack_ptr + ctx.stack_size;
+	return core::stack_walk(pc, fp, low, high, frames, max);
 }
-
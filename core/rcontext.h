@@ -3,6 +3,7 @@
 #include "../common/internal.h"
 
 #include "details/context.h"
+#include "stack.h"
 
 #include <cstdlib>
 #include <memory>
@@ -12,21 +13,134 @@ namespace rco {
 
 	/**
 	 * @brief Context的包装类
+	 *
+	 * 协程的栈在第一次切入前(acquire)才分配，协程结束后(release)立即归还，
+	 * 内存占用与正在运行的协程数成正比，而不是与排队的协程数成正比
 	 */
 	class RContext {
 		public:
 			typedef core::Context::rco_func rctx_fn;
 		
-			explicit RContext(rctx_fn pfn, void* arg, size_t stack_size);
+			/**
+			 * @brief 构造函数，不分配栈
+			 *
+			 * @param[in] pfn		 入口函数
+			 * @param[in] arg		 入口函数参数
+			 * @param[in] stack_size 栈大小，为0时表示线程自身的上下文
+			 * @param[in] mode		 栈的分配方式
+			 * @param[in] max_size	 eGrowable 时栈可扩展到的大小
+			 * @param[in] paint		 是否填充标记以统计栈使用量
+			 */
+			explicit RContext(rctx_fn pfn, void* arg, size_t stack_size,
+					core::Stack_mode mode = core::Stack_mode::eHeap, size_t max_size = 0, bool paint = false);
 			~RContext();
 
-			void swap_in();
-			void swap_out();
+			/**
+			 * @brief 是否可以切入(已分配栈，或为线程自身的上下文)
+			 *
+			 * @return 是 ? true : false
+			 */
+			RCO_INLINE bool ready() const {
+				return !stack_size || stack.base;
+			}
 
-			RContext& GetCtx();
+			/**
+			 * @brief 分配栈并初始化上下文
+			 *
+			 * @param[in] cache 栈缓存，为空时直接分配
+			 */
+			void acquire(core::Stack_cache* cache);
+
+			/**
+			 * @brief 归还栈，之后不能再切入该上下文
+			 *
+			 * @param[in] cache 栈缓存，为空时直接释放
+			 */
+			void release(core::Stack_cache* cache);
+
+			/**
+			 * @brief 从from切换到该上下文
+			 *
+			 * @param[in] from 当前上下文(如执行器的调度上下文)
+			 */
+			RCO_INLINE void swap_in(RContext& from) {
+				core::switch_context(&from.ctx, &ctx);
+			}
+
+			/**
+			 * @brief 从该上下文切换到to
+			 *
+			 * @param[in] to 目标上下文
+			 */
+			RCO_INLINE void swap_out(RContext& to) {
+				core::switch_context(&ctx, &to.ctx);
+			}
+
+			/**
+			 * @brief 处理栈访问异常(在 SIGSEGV 处理函数中调用)
+			 *
+			 * @param[in] addr 异常地址
+			 *
+			 * @return 处理结果
+			 */
+			RCO_INLINE core::Stack_fault fault(void* addr) {
+				return core::stack_fault(stack, addr);
+			}
+
+			/**
+			 * @brief 栈使用的最大深度(分配时需填充标记)
+			 *
+			 * @return 字节数
+			 */
+			RCO_INLINE size_t stack_used() const {
+				return core::stack_used(stack);
+			}
+
+			/**
+			 * @brief 栈的可用大小
+			 *
+			 * @return 字节数
+			 */
+			RCO_INLINE size_t stack_capacity() const {
+				return ctx.stack_size;
+			}
+
+			/**
+			 * @brief 从切出时保存的上下文沿帧指针回溯调用栈
+			 *
+			 * 只能回溯已切出的上下文；没有帧指针的函数(-fomit-frame-pointer)会被跳过或终止回溯
+			 *
+			 * @param[out] frames 返回地址，由内向外
+			 * @param[in]  max	  最多回溯的层数
+			 *
+			 * @return 层数，未分配栈或后端不支持时为0
+			 */
+			size_t backtrace(void** frames, size_t max) const;
+
+			/**
+			 * @brief 栈的地址范围
+			 *
+			 * @param[out] low	低地址端
+			 * @param[out] high 高地址端
+			 *
+			 * @return 已分配栈 ? true : false
+			 */
+			RCO_INLINE bool stack_range(uintptr_t& low, uintptr_t& high) const {
+				if(!stack_size || !stack.base) {
+					return false;
+				}
+				low = (uintptr_t)ctx.stack_ptr;
+				high = low + ctx.stack_size;
+				return true;
+			}
 		private:
-			core::Context ctx;
-			rctx_fn		  pfn;
-			void*		  pAllocator;
+			core::Context	 ctx;
+			core::Stack		 stack;
+			rctx_fn			 pfn;
+			void*			 arg;
+			size_t			 stack_size;
+			size_t			 max_size;
+			core::Stack_mode mode;
+			bool			 paint;
 	};
 }
@@ -0,0 +1,215 @@
+#include "stack.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// 扩展时至少提交的大小
+#define STACK_GROW_MIN	(16 * 1024)
+
+// 栈使用量检测的标记
+#define STACK_CANARY	0x5AFEC0DE5AFEC0DEull
+
+RCO_STATIC size_t Round_page(size_t size) {
+	size_t page = rco::core::page_size();
+	return (size + page - 1) & ~(page - 1);
+}
+
+size_t rco::core::page_size() {
+	RCO_STATIC const size_t s_page = sysconf(_SC_PAGESIZE);
+	return s_page;
+}
+
+char* rco::core::Stack::bottom() const {
+	return mode == Stack_mode::eHeap ? base : base + page_size();
+}
+
+size_t rco::core::Stack::usable() const {
+	return mode == Stack_mode::eHeap ? reserve : reserve - page_size();
+}
+
+bool rco::core::stack_alloc(Stack& stack, size_t size, Stack_mode mode, size_t max_size) {
+	stack.mode = mode;
+	stack.size = size;
+	stack.max_size = max_size;
+	stack.painted = false;
+
+	if(mode == Stack_mode::eHeap) {
+		stack.base = (char*)malloc(size);
+		stack.reserve = stack.base ? size : 0;
+		stack.committed = stack.base;
+		return stack.base;
+	}
+
+	size_t page = page_size();
+	size = Round_page(size);
+	size_t reserve = size + page;
+	if(mode == Stack_mode::eGrowable && max_size > size) {
+		reserve = Round_page(max_size) + page;
+	}
+
+	// eGrowable 只预留地址空间，提交的部分在下面设置为可读写
+	int prot = mode == Stack_mode::eGuard ? PROT_READ | PROT_WRITE : PROT_NONE;
+	void* ptr = mmap(nullptr, reserve, prot, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if(ptr == MAP_FAILED) {
+		stack.base = nullptr;
+		stack.reserve = 0;
+		return false;
+	}
+
+	stack.base = (char*)ptr;
+	stack.reserve = reserve;
+	stack.committed = stack.base + reserve - size;
+
+	if(mode == Stack_mode::eGuard) {
+		// 栈向低地址增长，保护页在栈底
+		mprotect(stack.base, page, PROT_NONE);
+	} else {
+		mprotect(stack.committed, size, PROT_READ | PROT_WRITE);
+	}
+	return true;
+}
+
+void rco::core::stack_free(Stack& stack) {
+	if(!stack.base) {
+		return;
+	}
+
+	if(stack.mode == Stack_mode::eHeap) {
+		free(stack.base);
+	} else {
+		munmap(stack.base, stack.reserve);
+	}
+	stack = Stack();
+}
+
+rco::core::Stack_cache::Stack_cache(size_t capacity)
+	: capacity(capacity) {
+		stacks.reserve(capacity);
+	}
+
+rco::core::Stack_cache::~Stack_cache() {
+	for(Stack& stack : stacks) {
+		stack_free(stack);
+	}
+}
+
+bool rco::core::Stack_cache::acquire(Stack& stack, size_t size, Stack_mode mode, size_t max_size) {
+	// 从最近归还的栈开始查找
+	for(size_t i = stacks.size(); i > 0; --i) {
+		Stack& cached = stacks[i - 1];
+		if(cached.mode == mode && cached.size == size
+				&& (mode != Stack_mode::eGrowable || cached.max_size == max_size)) {
+			stack = cached;
+			stack.painted = false;
+			cached = stacks.back();
+			stacks.pop_back();
+			return true;
+		}
+	}
+	return stack_alloc(stack, size, mode, max_size);
+}
+
+void rco::core::Stack_cache::release(Stack& stack) {
+	if(!stack.base) {
+		return;
+	}
+
+	if(stacks.size() < capacity) {
+		stacks.push_back(stack);
+		stack = Stack();
+		return;
+	}
+	stack_free(stack);
+}
+
+void rco::core::stack_paint(Stack& stack) {
+	if(!stack.base) {
+		return;
+	}
+
+	uint64_t* p = (uint64_t*)stack.committed;
+	uint64_t* end = (uint64_t*)(stack.base + stack.reserve);
+	while(p < end) {
+		*p++ = STACK_CANARY;
+	}
+	stack.painted = true;
+}
+
+size_t rco::core::stack_used(const Stack& stack) {
+	if(!stack.painted) {
+		return 0;
+	}
+
+	char* top = stack.base + stack.reserve;
+	const uint64_t* p = (const uint64_t*)stack.committed;
+	const uint64_t* end = (const uint64_t*)top;
+	while(p < end && *p == STACK_CANARY) {
+		++p;
+	}
+	return top - (const char*)p;
+}
+
+rco::core::Stack_fault rco::core::stack_fault(Stack& stack, void* addr) {
+	char* p = (char*)addr;
+	if(stack.mode == Stack_mode::eHeap || p < stack.base || p >= stack.base + stack.reserve) {
+		return Stack_fault::eNone;
+	}
+
+	char* bottom = stack.bottom();
+	if(stack.mode == Stack_mode::eGuard || p < bottom || p >= stack.committed) {
+		return Stack_fault::eOverflow;
+	}
+
+	// 至少扩展一倍，不超过预留区域
+	size_t page = page_size();
+	size_t committed = stack.base + stack.reserve - stack.committed;
+	size_t grow = committed < STACK_GROW_MIN ? STACK_GROW_MIN : committed;
+	char* low = (char*)((uintptr_t)p & ~(uintptr_t)(page - 1));
+	if(stack.committed - low < (ptrdiff_t)grow) {
+		low = stack.committed - grow;
+	}
+	if(low < bottom) {
+		low = bottom;
+	}
+
+	if(mprotect(low, stack.committed - low, PROT_READ | PROT_WRITE) != 0) {
+		return Stack_fault::eOverflow;
+	}
+	stack.committed = low;
+	return Stack_fault::eGrown;
+}
+
+size_t rco::core::stack_walk(void* pc, void* fp, uintptr_t low, uintptr_t high, void** frames, size_t max) {
+	if(!max) {
+		return 0;
+	}
+
+	size_t n = 0;
+	frames[n++] = pc;
+	while(n < max) {
+#if defined(__riscv)
+		// 帧指针指向栈帧的高地址端，其下为 ra 与上一层的帧指针
+		void* const* frame = (void* const*)fp - 2;
+#else
+		// 帧指针指向 {上一层的帧指针, 返回地址}
+		void* const* frame = (void* const*)fp;
+#endif
+		uintptr_t addr = (uintptr_t)frame;
+		// 帧必须在栈内、对齐，并且逐层向栈底方向移动
+		if(addr < low || addr + 2 * sizeof(void*) > high || addr % sizeof(void*)) {
+			break;
+		}
+
+		void* ret = frame[1];
+		if(!ret) {
+			break;
+		}
+		frames[n++] = ret;
+
+		low = addr + 2 * sizeof(void*);
+		fp = frame[0];
+	}
+	return n;
+}
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../common/internal.h"
+#include "../common/noncopyable.h"
+
+namespace rco {
+	namespace core {
+
+		/**
+		 * @brief 协程栈的分配方式
+		 */
+		enum class Stack_mode {
+			eHeap,		// malloc 分配，没有保护页(默认)
+			eGuard,		// mmap 分配，栈底设置保护页，溢出时触发 SIGSEGV 并报告协程id
+			eGrowable	// 预留较大的地址空间，只提交 stack_size，访问未提交的区域时在 SIGSEGV 中扩展
+		};
+
+		/**
+		 * @brief 栈访问异常的处理结果
+		 */
+		enum class Stack_fault {
+			eNone,		// 地址不在该栈的预留区域内
+			eGrown,		// 已扩展栈，可重新执行
+			eOverflow	// 访问了保护页，栈溢出
+		};
+
+		/**
+		 * @brief 协程栈
+		 *
+		 * | guard | 未提交(eGrowable) | 已提交 |
+		 * ^ base  ^ bottom()          ^ committed      ^ base + reserve
+		 */
+		struct Stack {
+			Stack()
+				: mode(Stack_mode::eHeap)
+				  , base(nullptr)
+				  , reserve(0)
+				  , committed(nullptr)
+				  , size(0)
+				  , max_size(0)
+				  , painted(false) {
+
+				  }
+
+			Stack_mode mode;
+			char*	   base;		// 分配的起始地址(含保护页)
+			size_t	   reserve;		// 分配的总大小
+			char*	   committed;	// 已提交区域的最低地址
+			size_t	   size;		// 分配时指定的大小
+			size_t	   max_size;	// 分配时指定的最大大小(eGrowable)
+			bool	   painted;		// 是否填充了栈使用量检测的标记
+
+			/**
+			 * @brief 可用区域(不含保护页)的最低地址
+			 */
+			char* bottom() const;
+
+			/**
+			 * @brief 可用区域的大小(eGrowable 时包括未提交的部分)
+			 */
+			size_t usable() const;
+		};
+
+		/**
+		 * @brief 页大小
+		 */
+		size_t page_size();
+
+		/**
+		 * @brief 分配协程栈
+		 *
+		 * @param[out] stack	  栈
+		 * @param[in]  size		  栈大小(eGrowable 时为初始提交的大小)
+		 * @param[in]  mode		  分配方式
+		 * @param[in]  max_size	  eGrowable 时栈可扩展到的大小
+		 *
+		 * @return 成功 ? true : false
+		 */
+		bool stack_alloc(Stack& stack, size_t size, Stack_mode mode, size_t max_size);
+
+		/**
+		 * @brief 释放协程栈
+		 *
+		 * @param[in] stack 栈
+		 */
+		void stack_free(Stack& stack);
+
+		/**
+		 * @brief 协程栈缓存，协程结束后归还的栈供之后的协程复用(非线程安全，每个执行器一个)
+		 */
+		class Stack_cache : public Noncopyable {
+			public:
+				/**
+				 * @brief 构造函数
+				 *
+				 * @param[in] capacity 最多缓存的栈数
+				 */
+				explicit Stack_cache(size_t capacity);
+
+				/**
+				 * @brief 析构函数，释放缓存的栈
+				 */
+				~Stack_cache();
+
+				/**
+				 * @brief 获取栈：优先复用分配参数相同的缓存栈，没有时重新分配
+				 *
+				 * @return 成功 ? true : false
+				 */
+				bool acquire(Stack& stack, size_t size, Stack_mode mode, size_t max_size);
+
+				/**
+				 * @brief 归还栈，缓存已满时释放
+				 *
+				 * @param[in] stack 栈
+				 */
+				void release(Stack& stack);
+
+			private:
+				std::vector<Stack> stacks;
+				size_t			   capacity;
+		};
+
+		/**
+		 * @brief 用标记填充已提交的栈，之后可通过 stack_used 得到栈使用的最大深度
+		 *
+		 * @param[in] stack 栈(需在初始化上下文之前填充)
+		 */
+		void stack_paint(Stack& stack);
+
+		/**
+		 * @brief 栈使用的最大深度：从栈底向上查找第一个被改写的标记
+		 *
+		 * eGrowable 栈扩展出的部分没有标记，按已全部使用计算
+		 *
+		 * @param[in] stack 栈
+		 *
+		 * @return 字节数，栈未填充标记时为0
+		 */
+		size_t stack_used(const Stack& stack);
+
+		/**
+		 * @brief 沿帧指针回溯调用栈，只读取 [low, high) 内的地址，可在信号处理函数中调用
+		 *
+		 * 没有帧指针的函数(-fomit-frame-pointer)会被跳过或终止回溯
+		 *
+		 * @param[in]  pc	  起始位置
+		 * @param[in]  fp	  起始位置的帧指针
+		 * @param[in]  low	  栈的低地址端(不低于当前栈顶)
+		 * @param[in]  high	  栈的高地址端
+		 * @param[out] frames 起始位置与各层的返回地址，由内向外
+		 * @param[in]  max	  最多回溯的层数
+		 *
+		 * @return 层数
+		 */
+		size_t stack_walk(void* pc, void* fp, uintptr_t low, uintptr_t high, void** frames, size_t max);
+
+		/**
+		 * @brief 处理栈访问异常，可在信号处理函数中调用
+		 *
+		 * @param[in] stack 栈
+		 * @param[in] addr	异常地址
+		 *
+		 * @return 处理结果
+		 */
+		Stack_fault stack_fault(Stack& stack, void* addr);
+	}
+}
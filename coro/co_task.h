@@ -0,0 +1,449 @@
+#pragma once
+
+// C++20 无栈协程适配，需要以 C++20 编译(CMake 选项 RCO_CXX20)
+#if __cplusplus >= 202002L && __has_include(<coroutine>)
+
+#define RCO_HAS_CO_TASK
+
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "../common/internal.h"
+#include "../scheduler/processor.h"
+#include "../scheduler/scheduler.h"
+
+namespace rco {
+
+	template <typename T = void>
+		class co_task;
+
+	namespace impl {
+
+		/**
+		 * @brief 获取当前调度器，不在执行器线程中时为默认调度器
+		 */
+		RCO_INLINE Scheduler* __co_scheduler() {
+			Scheduler* sched = Processor::CurrentScheduler();
+			return sched ? sched : &Scheduler::Instance();
+		}
+
+		/**
+		 * @brief 在调度器上恢复协程帧：创建一个无栈协程，在执行器的调度栈上执行 resume
+		 *
+		 * @param[in] handle 协程帧
+		 * @param[in] sched  调度器
+		 *
+		 * @return 成功 ? true : false(调度器正在关闭，不再接受协程，协程帧未恢复)
+		 */
+		RCO_INLINE bool __co_schedule(std::coroutine_handle<> handle, Scheduler* sched) {
+			Task::Attribute attr;
+			attr.stackless = true;
+			return sched->make_task([handle]{ handle.resume(); }, attr);
+		}
+
+		/**
+		 * @brief 使用 Scheduler::reserve_task 的预留恢复协程帧，可在执行器以外的线程中调用
+		 *
+		 * 挂起时预留，关闭过程会等待协程帧恢复并执行完毕；
+		 * 超时关闭后调度器已停止时协程帧不再恢复(与被取消的有栈协程一致)，不会在当前线程中恢复
+		 *
+		 * @param[in] handle 协程帧
+		 * @param[in] sched  调度器
+		 */
+		RCO_INLINE void __co_schedule_reserved(std::coroutine_handle<> handle, Scheduler* sched) {
+			Task::Attribute attr;
+			attr.stackless = true;
+			sched->make_reserved_task([handle]{ handle.resume(); }, attr);
+		}
+
+		struct __co_promise_base {
+			/**
+			 * @brief 协程结束时恢复等待者(对称转移，不增加栈深度)
+			 */
+			struct final_awaiter {
+				bool await_ready() noexcept {
+					return false;
+				}
+
+				template <typename Promise>
+					std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+						std::coroutine_handle<> waiter = handle.promise().continuation;
+						return waiter ? waiter : std::noop_coroutine();
+					}
+
+				void await_resume() noexcept {}
+			};
+
+			// 惰性启动：被 co_await 或 co_spawn 时才开始执行
+			std::suspend_always initial_suspend() noexcept {
+				return {};
+			}
+
+			final_awaiter final_suspend() noexcept {
+				return {};
+			}
+
+			void unhandled_exception() {
+				error = std::current_exception();
+			}
+
+			std::coroutine_handle<> continuation;	// 等待该协程的协程帧
+			std::exception_ptr		error;
+		};
+
+		template <typename T>
+			struct __co_promise : __co_promise_base {
+				co_task<T> get_return_object() noexcept;
+
+				template <typename U>
+					void return_value(U&& value) {
+						result.emplace(std::forward<U>(value));
+					}
+
+				T get() {
+					if(error) {
+						std::rethrow_exception(error);
+					}
+					return std::move(*result);
+				}
+
+				std::optional<T> result;
+			};
+
+		template <>
+			struct __co_promise<void> : __co_promise_base {
+				co_task<void> get_return_object() noexcept;
+
+				void return_void() noexcept {}
+
+				void get() {
+					if(error) {
+						std::rethrow_exception(error);
+					}
+				}
+			};
+
+		/**
+		 * @brief 分离的协程帧，结束时自行销毁(co_spawn 与 co_wait 使用)
+		 */
+		struct __co_detached {
+			struct promise_type {
+				__co_detached get_return_object() noexcept {
+					return __co_detached{std::coroutine_handle<promise_type>::from_promise(*this)};
+				}
+
+				std::suspend_always initial_suspend() noexcept {
+					return {};
+				}
+
+				std::suspend_never final_suspend() noexcept {
+					return {};
+				}
+
+				void return_void() noexcept {}
+
+				// 与有栈协程一致，未捕获的异常被忽略
+				void unhandled_exception() noexcept {}
+			};
+
+			std::coroutine_handle<promise_type> handle;
+		};
+
+		/**
+		 * @brief 等待结果(co_wait、co_blocking 使用)
+		 */
+		template <typename T>
+			struct __co_wait_state {
+				std::optional<T>   result;
+				std::exception_ptr error;
+
+				T get() {
+					if(error) {
+						std::rethrow_exception(error);
+					}
+					return std::move(*result);
+				}
+			};
+
+		template <>
+			struct __co_wait_state<void> {
+				std::exception_ptr error;
+
+				void get() {
+					if(error) {
+						std::rethrow_exception(error);
+					}
+				}
+			};
+	}
+
+	/**
+	 * @brief C++20 无栈协程
+	 *
+	 * 协程帧在堆上分配，只保存跨越挂起点的局部变量，远小于有栈协程的栈；
+	 * 通过 co_spawn 在执行器上运行，可以 co_await 其他 co_task、co_yield_now、co_blocking，
+	 * 有栈协程可以通过 co_wait 等待其结果
+	 *
+	 * @tparam T 返回值类型
+	 */
+	template <typename T>
+		class co_task {
+			public:
+				typedef impl::__co_promise<T> promise_type;
+				typedef std::coroutine_handle<promise_type> handle_type;
+
+				co_task() noexcept
+					: handle(nullptr) {}
+
+				explicit co_task(handle_type h) noexcept
+					: handle(h) {}
+
+				co_task(co_task&& other) noexcept
+					: handle(std::exchange(other.handle, nullptr)) {}
+
+				co_task& operator = (co_task&& other) noexcept {
+					if(this != &other) {
+						if(handle) {
+							handle.destroy();
+						}
+						handle = std::exchange(other.handle, nullptr);
+					}
+					return *this;
+				}
+
+				co_task(const co_task&) = delete;
+				co_task& operator = (const co_task&) = delete;
+
+				~co_task() {
+					if(handle) {
+						handle.destroy();
+					}
+				}
+
+				RCO_INLINE bool done() const noexcept {
+					return !handle || handle.done();
+				}
+
+				RCO_INLINE promise_type& promise() const noexcept {
+					return handle.promise();
+				}
+
+				/**
+				 * @brief 等待该协程执行完毕：切入该协程，结束时恢复等待者
+				 */
+				auto operator co_await() && noexcept {
+					struct awaiter {
+						handle_type handle;
+
+						bool await_ready() noexcept {
+							return !handle || handle.done();
+						}
+
+						std::coroutine_handle<> await_suspend(std::coroutine_handle<> waiter) noexcept {
+							handle.promise().continuation = waiter;
+							return handle;
+						}
+
+						T await_resume() {
+							if(!handle) {
+								throw std::logic_error("co_await on an empty co_task");
+							}
+							return handle.promise().get();
+						}
+					};
+					return awaiter{handle};
+				}
+
+			private:
+				handle_type handle;
+		};
+
+	namespace impl {
+		template <typename T>
+			RCO_INLINE co_task<T> __co_promise<T>::get_return_object() noexcept {
+				return co_task<T>(std::coroutine_handle<__co_promise<T>>::from_promise(*this));
+			}
+
+		RCO_INLINE co_task<void> __co_promise<void>::get_return_object() noexcept {
+			return co_task<void>(std::coroutine_handle<__co_promise<void>>::from_promise(*this));
+		}
+
+		RCO_INLINE __co_detached __co_run(co_task<void> task) {
+			co_await std::move(task);
+		}
+
+		template <typename T, typename Notify>
+			__co_detached __co_notify(co_task<T> task, __co_wait_state<T>* state, Notify notify) {
+				try {
+					if constexpr (std::is_void<T>::value) {
+						co_await std::move(task);
+					} else {
+						state->result.emplace(co_await std::move(task));
+					}
+				} catch(...) {
+					state->error = std::current_exception();
+				}
+				notify();
+			}
+	}
+
+	/**
+	 * @brief 在调度器上运行 co_task，调用立即返回
+	 *
+	 * @param[in] task	协程
+	 * @param[in] sched 调度器，为空时为当前调度器
+	 *
+	 * @return 成功 ? true : false(调度器正在关闭，不再接受协程，task 被销毁而不执行)
+	 */
+	RCO_INLINE bool co_spawn(co_task<void> task, Scheduler* sched = nullptr) {
+		impl::__co_detached run = impl::__co_run(std::move(task));
+		if(!impl::__co_schedule(run.handle, sched ? sched : impl::__co_scheduler())) {
+			run.handle.destroy();
+			return false;
+		}
+		return true;
+	}
+
+	/**
+	 * @brief 让出执行器：协程帧重新加入调度器的队列，调度器已停止时不让出
+	 */
+	RCO_INLINE auto co_yield_now() noexcept {
+		struct awaiter {
+			Scheduler* sched;
+
+			bool await_ready() noexcept {
+				return false;
+			}
+
+			bool await_suspend(std::coroutine_handle<> handle) {
+				// 未能加入队列时继续执行
+				return impl::__co_schedule(handle, sched);
+			}
+
+			void await_resume() noexcept {}
+		};
+		return awaiter{impl::__co_scheduler()};
+	}
+
+	/**
+	 * @brief 在阻塞调用线程池中执行 fn，执行完毕后在调度器上恢复协程，fn 抛出的异常在协程中重新抛出
+	 *
+	 * @param[in] fn 阻塞调用
+	 *
+	 * @return fn 的返回值
+	 */
+	template <typename Fn>
+		RCO_INLINE auto co_blocking(Fn fn) {
+			typedef decltype(fn()) R;
+			struct awaiter {
+				Fn						  fn;
+				Scheduler*				  sched;
+				impl::__co_wait_state<R>  state;
+
+				bool await_ready() noexcept {
+					return false;
+				}
+
+				void call() {
+					try {
+						if constexpr (std::is_void<R>::value) {
+							fn();
+						} else {
+							state.result.emplace(fn());
+						}
+					} catch(...) {
+						state.error = std::current_exception();
+					}
+				}
+
+				bool await_suspend(std::coroutine_handle<> handle) {
+					// 挂起期间计入调度器未完成的协程数，关闭过程等待协程帧恢复
+					if(!sched->reserve_task()) {
+						// 调度器正在关闭，直接执行，不挂起
+						call();
+						return false;
+					}
+					sched->post_blocking([this, handle]{
+							call();
+							impl::__co_schedule_reserved(handle, sched);
+							});
+					return true;
+				}
+
+				R await_resume() {
+					return state.get();
+				}
+			};
+			return awaiter{std::move(fn), impl::__co_scheduler(), {}};
+		}
+
+	/**
+	 * @brief 等待 co_task 执行完毕并返回其结果
+	 *
+	 * 在有栈协程中挂起当前协程(CoPark)，co_task 结束后唤醒(CoWake)；不在协程中时阻塞当前线程；
+	 * 无栈协程不能挂起，调度器正在关闭、不再接受协程时同样抛出 std::logic_error
+	 *
+	 * @param[in] task	co_task
+	 * @param[in] sched 运行 co_task 的调度器，为空时为当前调度器
+	 *
+	 * @return co_task 的返回值
+	 */
+	template <typename T>
+		T co_wait(co_task<T> task, Scheduler* sched = nullptr) {
+			Task* current = Processor::CurrentTask();
+			if(!sched) {
+				sched = impl::__co_scheduler();
+			}
+			impl::__co_wait_state<T> state;
+
+			if(current && current->stackless()) {
+				throw std::logic_error("stackless task cannot wait for co_task");
+			}
+
+			if(current) {
+				// 挂起之前预留，切出后创建运行 co_task 的协程不会被拒绝
+				if(!sched->reserve_task()) {
+					throw std::logic_error("scheduler is shutting down");
+				}
+
+				// 等待期间持有协程的引用，调度器关闭时协程可能被取消
+				current->increment_ref();
+				impl::__co_detached run = impl::__co_notify(std::move(task), &state, [current]{
+						Processor::CoWake(current);
+						current->decrement_ref();
+						});
+
+				// 协程切出后再开始执行，保证唤醒一定发生在挂起之后
+				Processor::CoPark([run, sched]{
+						impl::__co_schedule_reserved(run.handle, sched);
+						}, "co_wait");
+				return state.get();
+			}
+
+			std::mutex mutex;
+			std::condition_variable cv;
+			bool finished = false;
+			impl::__co_detached run = impl::__co_notify(std::move(task), &state, [&]{
+					std::unique_lock<std::mutex> scope_lock(mutex);
+					finished = true;
+					cv.notify_one();
+					});
+			if(!impl::__co_schedule(run.handle, sched)) {
+				run.handle.destroy();
+				throw std::logic_error("scheduler is shutting down");
+			}
+
+			std::unique_lock<std::mutex> scope_lock(mutex);
+			cv.wait(scope_lock, [&]{ return finished; });
+			return state.get();
+		}
+}
+
+#endif
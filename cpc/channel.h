@@ -23,6 +23,7 @@ namespace rco {
 				eClosed
 			};
 			using FlagBits = Flags<State>;
+			using Buf_state = typename cas::LockFreeRingBuf<T>::State;
 
 			explicit Channel(size_t size)
 				: buf(size){
@@ -36,6 +37,28 @@ namespace rco {
 			RCO_INLINE void operator >> (T& param) {
 				buf.pop(param);
 			}
+
+			/**
+			 * @brief 非阻塞发送
+			 *
+			 * @param[in] param 元素(成功时被移走)
+			 *
+			 * @return 成功 ? true : false(缓冲区已满)
+			 */
+			RCO_INLINE bool try_send(T& param) {
+				return !!(buf.push(std::move(param)) & Buf_state::eSuccess);
+			}
+
+			/**
+			 * @brief 非阻塞接收
+			 *
+			 * @param[out] param 元素
+			 *
+			 * @return 成功 ? true : false(缓冲区为空)
+			 */
+			RCO_INLINE bool try_recv(T& param) {
+				return !!(buf.pop(param) & Buf_state::eSuccess);
+			}
 			private:
 
 			bool has_buf() {
@@ -6,3 +6,15 @@
 #define __rco_impl ::rco::impl::__rco() +
 #define rco_exec __rco_impl
 #define rco_sched rco::Scheduler::Instance()
+
+// 带选项创建协程: rco_go - rco_preemptible - rco_scheduler(sched) + fn
+#define rco_go ::rco::impl::__rco()
+#define rco_preemptible ::rco::impl::__rco_option< ::rco::impl::Opt::ePreemptible>()
+// 不会挂起的协程，在执行器的调度栈上执行: rco_go - rco_stackless + fn
+#define rco_stackless ::rco::impl::__rco_option< ::rco::impl::Opt::eStackless>()
+// 批量创建 n 个协程(最后一个选项)，一次加锁放入每个执行器: rco_go - rco_batch(n) + [](std::size_t i){}
+#define rco_batch(n) ::rco::impl::__rco_option< ::rco::impl::Opt::eBatch>(n)
+#define rco_scheduler(s) ::rco::impl::__rco_option< ::rco::impl::Opt::eScheduler>(s)
+#define rco_stack_size(n) ::rco::impl::__rco_option< ::rco::impl::Opt::eStackSize>(n)
+// 栈的分配方式: rco_go - rco_stack_mode(rco::core::Stack_mode::eGuard) + fn
+#define rco_stack_mode(m) ::rco::impl::__rco_option< ::rco::impl::Opt::eStackMode>(m)
@@ -14,7 +14,11 @@ namespace rco {
 		enum class Opt{
 			eScheduler,
 			eStackSize,
-			eDispath
+			eStackMode,
+			eDispath,
+			ePreemptible,
+			eStackless,
+			eBatch
 		};
 
 		template <Opt Opt_t>
@@ -34,25 +38,53 @@ namespace rco {
 				explicit __rco_option(std::size_t ss)
 					: __stack_size(ss) {}
 			};
+		template <>
+			struct __rco_option<Opt::eStackMode> {
+				core::Stack_mode __stack_mode;
+				explicit __rco_option(core::Stack_mode mode)
+					: __stack_mode(mode) {}
+			};
 		template <>
 			struct __rco_option<Opt::eDispath> {
 			};
+		template <>
+			struct __rco_option<Opt::ePreemptible> {
+			};
+		template <>
+			struct __rco_option<Opt::eStackless> {
+			};
+		template <>
+			struct __rco_option<Opt::eBatch> {
+				std::size_t __count;
+				explicit __rco_option(std::size_t count)
+					: __count(count) {}
+			};
+
+		struct __rco;
+
+		/**
+		 * @brief 批量创建协程，由 rco_batch(n) 选项产生，必须为最后一个选项
+		 */
+		struct __rco_batch {
+			template <typename Co_Task>
+				RCO_NOINLINE bool operator + (const Co_Task& fun);
+
+			__rco& rco_base;
+			std::size_t rco_count;
+		};
 
 
 		struct __rco {
             __rco() {
 				rco_scheduler = nullptr;
+				rco_stack_mode_set = false;
 			}
 
+			// 不内联，返回地址即为创建协程的位置(用于栈使用量统计)
 			template <typename Co_Task>
-				RCO_INLINE void operator + (const Co_Task& fun) {
-					if(!rco_scheduler) {
-						rco_scheduler = Processor::CurrentScheduler();
-					}
-					if(!rco_scheduler) {
-						rco_scheduler = &Scheduler::Instance();
-					}
-					rco_scheduler->make_task(fun, rco_task_attr);
+				RCO_NOINLINE bool operator + (const Co_Task& fun) {
+					rco_task_attr.spawn_site = __builtin_return_address(0);
+					return prepare()->make_task(fun, rco_task_attr);
 				}
 
 			RCO_INLINE __rco& operator - (const __rco_option<Opt::eScheduler>& opt) {
@@ -63,10 +95,50 @@ namespace rco {
 				rco_task_attr.stack_size = opt.__stack_size;
 				return *this;
 			}
+			RCO_INLINE __rco& operator - (const __rco_option<Opt::eStackMode>& opt) {
+				rco_task_attr.stack_mode = opt.__stack_mode;
+				rco_stack_mode_set = true;
+				return *this;
+			}
+			RCO_INLINE __rco& operator - (const __rco_option<Opt::ePreemptible>&) {
+				rco_task_attr.preemptible = true;
+				return *this;
+			}
+			RCO_INLINE __rco& operator - (const __rco_option<Opt::eStackless>&) {
+				rco_task_attr.stackless = true;
+				return *this;
+			}
+			RCO_INLINE __rco_batch operator - (const __rco_option<Opt::eBatch>& opt) {
+				return __rco_batch{*this, opt.__count};
+			}
+
+			// 按选项补全调度器与栈配置
+			RCO_INLINE Scheduler* prepare() {
+				if(!rco_scheduler) {
+					rco_scheduler = Processor::CurrentScheduler();
+				}
+				if(!rco_scheduler) {
+					rco_scheduler = &Scheduler::Instance();
+				}
+				// 未指定栈的分配方式时使用调度器的配置
+				if(!rco_stack_mode_set) {
+					rco_task_attr.stack_mode = rco_scheduler->get_config().stack_mode;
+				}
+				rco_task_attr.max_stack_size = rco_scheduler->get_config().max_stack_size;
+				return rco_scheduler;
+			}
 
 			Task::Attribute rco_task_attr;
 			Scheduler* rco_scheduler;
+			bool rco_stack_mode_set;
 		};
 
+		// 执行实体的参数为协程序号 [0, n)
+		template <typename Co_Task>
+			bool __rco_batch::operator + (const Co_Task& fun) {
+				rco_base.rco_task_attr.spawn_site = __builtin_return_address(0);
+				return rco_base.prepare()->make_tasks(rco_count, fun, rco_base.rco_task_attr);
+			}
+
 	}
 }
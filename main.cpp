@@ -6,17 +6,43 @@
 
 #include "rco.h"
 
+#if defined(RCO_HAS_CO_TASK)
+static rco::co_task<int> Square(int n) {
+    co_await rco::co_yield_now();
+    co_return n * n;
+}
+
+static rco::co_task<void> Sum_squares(int n) {
+    int sum = 0;
+    for(int i = 1; i <= n; ++i) {
+        sum += co_await Square(i);
+    }
+    std::cout << "co_task sum " << sum << std::endl;
+}
+#endif
+
 int main(int argc, char** argv) {
 
     //rco::Runtime::Set_GC_threshold(10);
 
-    for(int i = 1; i <= 3000; ++i) {
-        rco_exec [=]{
-            std::cout << "co " << i << " exec" << std::endl;
-        };
-    }
+    // 一次创建 3000 个协程，每个执行器只加锁一次
+    rco_go - rco_batch(3000) + [](std::size_t i) {
+        std::cout << "co " << i + 1 << " exec" << std::endl;
+    };
+
+#if defined(RCO_HAS_CO_TASK)
+    rco::co_spawn(Sum_squares(10));
+    rco_exec []{
+        // 有栈协程等待 co_task 的结果
+        int v = rco::co_wait(Square(12));
+        std::cout << "co_wait " << v << std::endl;
+    };
+#endif
+
+    rco_sched.start(2, 0, true);
 
-    rco_sched.start(2, 0);
+    // 等待所有协程执行完毕后关闭调度器
+    rco_sched.shutdown(std::chrono::seconds(5));
     std::cout << "main finish" << std::endl;
 
     return 0;
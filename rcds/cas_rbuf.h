@@ -42,9 +42,9 @@ namespace rco {
 					 * @param[in] capacity 缓冲区容积
 					 */
 					explicit LockFreeRingBuf(uint32_t capacity)
-						: buf_capacity(capacity + 1)/*预留一个单元不存储*/
-						  , write(0, capacity)  /*可写范围为0,buf_cap -1*/
-						  , read(0, 0) {
+						: write(0, capacity)  /*可写范围为0,buf_cap -1*/
+						  , read(0, 0)
+						  , buf_capacity(capacity + 1)/*预留一个单元不存储*/ {
 							  assert(capacity);
 							  buffer = (T*)malloc(sizeof(T) * buf_capacity);
 						  }
@@ -102,12 +102,12 @@ namespace rco {
 							// 2. 写入
 							new(buffer + write_range.begin) T(std::forward<M>(t));
 
-							// 3. 更新可读区间
+							// 3. 更新可读区间，等待之前的写入者先更新(按写入顺序依次可读)
 							uint32_t read_end;
 							do {
-								read_end = relaxed(read.end);
-							} while (!read.end.compare_exchange_weak(write_range.begin
-										, (read_end + 1) % buf_capacity
+								read_end = write_range.begin;
+							} while (!read.end.compare_exchange_weak(read_end
+										, (write_range.begin + 1) % buf_capacity
 										, std::memory_order_acq_rel, std::memory_order_relaxed));
 
 							// 4. 更新状态
@@ -142,9 +142,11 @@ namespace rco {
 						t = std::move(buffer[read_range.begin]);
 						buffer[read_range.begin].~T();
 						
-						// 3.更新写入范围
-						uint32_t check = (read.begin + buf_capacity - 1) % buf_capacity;
-						while(!write.end.compare_exchange_weak(check, read.begin
+						// 3.更新写入范围，等待之前的读取者先更新(读取完的单元才可写)
+						uint32_t check;
+						do {
+							check = (read_range.begin + buf_capacity - 1) % buf_capacity;
+						} while(!write.end.compare_exchange_weak(check, read_range.begin
 									, std::memory_order_acq_rel, std::memory_order_relaxed));
 
 						// 4.检查读取时是否为full状态
@@ -165,6 +165,11 @@ namespace rco {
 					return std::move(TSList<T>());
 				}
 
+				// 截取数量不小于元素个数，直接取出全部元素
+				if (n >= element_count) {
+					return std::move(*this);
+				}
+
 				TSList<T> o;
 				auto pos = list_head;
 				// 遍历到第n个元素
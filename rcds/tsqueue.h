@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <cassert>
 #include <type_traits>
 #include <mutex>
@@ -52,10 +53,15 @@ namespace rco {
 
         RCO_INLINE void front(T* & out) {
             lock_guard scope_lock(*lock);
+            nolock_front(out);
+        }
+
+        RCO_INLINE T* nolock_front(T* & out) {
             out = (T*)head->next;
             if(out) {
                 out->check = check;
             }
+            return out;
         }
 
         RCO_INLINE void next(T* ptr, T* & out) {
@@ -68,20 +74,30 @@ namespace rco {
             if(out) {
                 out->check = check;
             }
+            return out;
         }
 
         RCO_INLINE bool ts_empty() {
             lock_guard scope_lock(*lock);
-            return !count;
+            return !approx_size();
         }
 
         RCO_INLINE bool empty() {
-            return !count;
+            return !approx_size();
         }
 
         RCO_INLINE std::size_t size() {
             lock_guard scope_lock(*lock);
-            return count;
+            return approx_size();
+        }
+
+        /**
+         * @brief 不加锁读取元素个数(可能读到旧值)，用于估计负载
+         *
+         * @return 元素个数
+         */
+        RCO_INLINE std::size_t approx_size() const {
+            return count.load(std::memory_order_relaxed);
         }
 
         RCO_INLINE T* pop() {
@@ -99,7 +115,7 @@ namespace rco {
             if(ptr->next) ptr->next->prev = head;
             ptr->prev = ptr->next = nullptr;
             ptr->check = nullptr;
-            --count;
+            add_count(-1);
 
             DecrementRef((T*)ptr);
 
@@ -120,7 +136,7 @@ namespace rco {
 
             Intrusive_queue* list_head = elements.list_head;
 
-            count += elements.size();
+            add_count(elements.size());
             tail->link(list_head);
 
             tail = elements.list_tail;
@@ -144,13 +160,13 @@ namespace rco {
             elem->next = nullptr;
             elem->check = check;
 
-            ++count;
+            add_count(1);
 
             if(ref_count) {
                 IncrementRef(element);
             }
 
-            return count;
+            return approx_size();
         }
 
         RCO_INLINE TSList<T> trunc_front(uint32_t n) {
@@ -176,7 +192,7 @@ namespace rco {
 
             if(last->next) last->next->prev = head;
             first->prev = last->next = nullptr;
-            count -= cnt;
+            add_count(-(std::ptrdiff_t)cnt);
 
             return std::move(TSList<T>(first, last, cnt));
         }
@@ -201,7 +217,7 @@ namespace rco {
 
             tail = first->prev;
             first->prev = tail->next = nullptr;
-            count -= cnt;
+            add_count(-(std::ptrdiff_t)cnt);
             return std::move(TSList<T>(first, last, cnt));
         }
 
@@ -220,10 +236,11 @@ namespace rco {
             tail = head;
 
             head->next = nullptr;
-            first->prev = last->prev = nullptr;
+            first->prev = nullptr;
+            assert(last->next == nullptr);
 
-            size_t cnt = count;
-            count = 0;
+            size_t cnt = approx_size();
+            count.store(0, std::memory_order_relaxed);
 
             return TSList<T>(first, last, cnt);
         }
@@ -249,8 +266,8 @@ namespace rco {
 
             element->prev = element->next = nullptr;
             element->check = nullptr;
-            assert(count > 0);
-            -- count;
+            assert(approx_size() > 0);
+            add_count(-1);
 
             if(ref_count) {
                 DecrementRef((T*)element);
@@ -261,13 +278,20 @@ namespace rco {
 
         void* check;
     private:
+        /**
+         * @brief 修改元素个数，只在持有锁时调用(只有一个写入者，不需要原子的读-改-写)
+         */
+        RCO_INLINE void add_count(std::ptrdiff_t n) {
+            count.store(count.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+
 
         lock_t	own_lock;
         lock_t* lock;
         Intrusive_queue* head;
         Intrusive_queue* tail;
 
-        std::size_t count;
+        std::atomic<std::size_t> count; // 元素个数，持有锁时修改，可以不加锁读取
     };
 
 }
@@ -1,5 +1,10 @@
 #pragma once
 
 #include "scheduler/scheduler.h"
+#include "scheduler/blocking_pool.h"
+#include "scheduler/trace.h"
+#include "scheduler/cpu_profile.h"
+#include "task/stack_profile.h"
 #include "indirect/rco_def.h"
 #include "defer/defer.h"
+#include "coro/co_task.h"
@@ -0,0 +1,134 @@
+#include "blocking_pool.h"
+
+#include <chrono>
+#include <thread>
+
+#include "processor.h"
+#include "scheduler.h"
+
+RCO_CONSTEXPR uint32_t rco::Blocking_pool::kIdleTimeoutSec;
+
+rco::Blocking_pool::Blocking_pool(uint16_t max_threads)
+	: max_threads(max_threads ? max_threads : 1)
+	  , threads(0)
+	  , idle(0)
+	  , stopped(false) {
+
+	  }
+
+rco::Blocking_pool::~Blocking_pool() {
+	std::unique_lock<std::mutex> scope_lock(mutex);
+	stopped = true;
+	cv.notify_all();
+
+	// 等待所有线程执行完剩余任务并退出
+	while(threads > 0) {
+		exit_cv.wait(scope_lock);
+	}
+}
+
+bool rco::Blocking_pool::shutdown(std::chrono::steady_clock::time_point deadline) {
+	std::unique_lock<std::mutex> scope_lock(mutex);
+	stopped = true;
+	cv.notify_all();
+
+	return exit_cv.wait_until(scope_lock, deadline, [this]{
+			return threads == 0;
+			});
+}
+
+void rco::Blocking_pool::post(Job&& job) {
+	std::unique_lock<std::mutex> scope_lock(mutex);
+
+	// 线程池已停止，在调用线程中直接执行
+	if(stopped) {
+		scope_lock.unlock();
+		job();
+		return;
+	}
+
+	jobs.push_back(std::move(job));
+
+	// 有空闲线程，直接唤醒
+	if(idle > 0) {
+		cv.notify_one();
+		return;
+	}
+
+	// 没有空闲线程并且未达到上限，创建新线程
+	// 达到上限时任务排队，等待线程空闲
+	if(threads < max_threads) {
+		++threads;
+		std::thread([this]{
+				this->work();
+				}).detach();
+	}
+}
+
+void rco::Blocking_pool::set_max_threads(uint16_t n) {
+	std::unique_lock<std::mutex> scope_lock(mutex);
+	max_threads = n ? n : 1;
+}
+
+uint16_t rco::Blocking_pool::thread_count() {
+	std::unique_lock<std::mutex> scope_lock(mutex);
+	return threads;
+}
+
+void rco::Blocking_pool::work() {
+	std::unique_lock<std::mutex> scope_lock(mutex);
+
+	while(true) {
+		if(jobs.empty()) {
+			if(stopped) {
+				break;
+			}
+
+			// 等待任务，超时则退出线程
+			++idle;
+			bool timeout = !cv.wait_for(scope_lock, std::chrono::seconds(kIdleTimeoutSec), [this]{
+					return stopped || !jobs.empty();
+					});
+			--idle;
+
+			if(timeout) {
+				break;
+			}
+			continue;
+		}
+
+		Job job = std::move(jobs.front());
+		jobs.pop_front();
+
+		scope_lock.unlock();
+		job();
+		scope_lock.lock();
+	}
+
+	--threads;
+	exit_cv.notify_all();
+}
+
+void rco::blocking(const std::function<void()>& fn) {
+	Task* task = Processor::CurrentTask();
+
+	// 不在协程中或在无栈协程中，直接执行
+	if(!task || task->stackless()) {
+		fn();
+		return;
+	}
+
+	Scheduler* scheduler = Processor::CurrentScheduler();
+
+	// 任务执行期间持有协程的引用，调度器关闭时协程可能被取消
+	task->increment_ref();
+
+	// 挂起当前协程，协程切出后再投递任务，保证唤醒一定发生在挂起之后
+	Processor::CoPark([=]{
+			scheduler->blocking_pool.post([=]{
+					fn();
+					Processor::CoWake(task);
+					task->decrement_ref();
+					});
+			}, "blocking");
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+#include "../common/internal.h"
+#include "../common/noncopyable.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+
+namespace rco {
+
+	/**
+	 * @brief 阻塞调用线程池，用于执行无法避免的阻塞调用(DNS解析、fsync等)
+	 *
+	 * 线程按需创建，数量不超过上限，空闲超时后自动退出
+	 */
+	class Blocking_pool : public Noncopyable {
+		public:
+			typedef std::function<void()> Job;
+
+			/**
+			 * @brief 构造函数
+			 *
+			 * @param[in] max_threads 线程数上限
+			 */
+			explicit Blocking_pool(uint16_t max_threads);
+
+			/**
+			 * @brief 析构函数，执行完剩余任务并等待所有线程退出
+			 */
+			~Blocking_pool();
+
+			/**
+			 * @brief 投递任务
+			 *
+			 * @param[in] job 任务
+			 */
+			void post(Job&& job);
+
+			/**
+			 * @brief 停止线程池：不再接受新任务，等待已投递的任务执行完毕，所有线程退出
+			 *
+			 * @param[in] deadline 等待的截止时刻
+			 *
+			 * @return 所有线程都已退出 ? true : false(仍有线程阻塞在任务中)
+			 */
+			bool shutdown(std::chrono::steady_clock::time_point deadline);
+
+			/**
+			 * @brief 设置线程数上限
+			 *
+			 * @param[in] n 上限
+			 */
+			void set_max_threads(uint16_t n);
+
+			/**
+			 * @brief 获取当前线程数
+			 *
+			 * @return 线程数
+			 */
+			uint16_t thread_count();
+
+			// 空闲线程的存活时间(秒)
+			RCO_STATIC RCO_CONSTEXPR uint32_t kIdleTimeoutSec = 10;
+
+		private:
+			/**
+			 * @brief 工作线程主循环
+			 */
+			void work();
+
+		private:
+			std::mutex				mutex;
+			std::condition_variable	cv;			// 任务到来
+			std::condition_variable	exit_cv;	// 线程退出
+
+			std::deque<Job>			jobs;		// 任务队列
+
+			uint16_t				max_threads;// 线程数上限
+			uint16_t				threads;	// 当前线程数
+			uint16_t				idle;		// 空闲线程数
+			bool					stopped;
+	};
+
+	/**
+	 * @brief 执行阻塞调用
+	 *
+	 * 在协程中调用时，挂起当前协程，在阻塞调用线程池中执行fn，执行完毕后恢复协程，
+	 * 执行器在此期间继续调度其他协程；不在协程中或在无栈协程中时直接执行fn
+	 *
+	 * @param[in] fn 阻塞调用
+	 */
+	void blocking(const std::function<void()>& fn);
+
+	namespace impl {
+		template <typename R>
+			struct __blocking_result {
+				template <typename Fn>
+					RCO_STATIC R call(Fn& fn) {
+						std::unique_ptr<R> result;
+						std::exception_ptr error;
+						blocking(std::function<void()>([&]{
+								try {
+									result.reset(new R(fn()));
+								} catch(...) {
+									error = std::current_exception();
+								}
+							}));
+						if(error) {
+							std::rethrow_exception(error);
+						}
+						return std::move(*result);
+					}
+			};
+
+		template <>
+			struct __blocking_result<void> {
+				template <typename Fn>
+					RCO_STATIC void call(Fn& fn) {
+						std::exception_ptr error;
+						blocking(std::function<void()>([&]{
+								try {
+									fn();
+								} catch(...) {
+									error = std::current_exception();
+								}
+							}));
+						if(error) {
+							std::rethrow_exception(error);
+						}
+					}
+			};
+	}
+
+	/**
+	 * @brief 执行阻塞调用并返回其结果，fn抛出的异常在协程中重新抛出
+	 *
+	 * @param[in] fn 阻塞调用
+	 *
+	 * @return fn的返回值
+	 */
+	template <typename Fn>
+		RCO_INLINE auto blocking(Fn fn) -> decltype(fn()) {
+			return impl::__blocking_result<decltype(fn())>::call(fn);
+		}
+}
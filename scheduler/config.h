@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "../core/stack.h"
+
+namespace rco {
+
+	/**
+	 * @brief 新协程的放置策略(被唤醒的协程仍回到所属的执行器)
+	 */
+	enum class Placement : uint8_t {
+		eLocal,			// 在本调度器的协程中创建时放入当前执行器，否则按 eTwoChoices 选择
+		eTwoChoices		// 随机选取两个激活的执行器，放入可执行协程较少的一个
+	};
+
+	/**
+	 * @brief 运行中可修改的配置项
+	 *
+	 * Runtime::Set_xxx 在任意线程中修改，分发线程、执行器与创建协程的线程同时读取，
+	 * 以 relaxed 原子操作读写(各项之间不需要同步)；可以复制，便于按值传递配置
+	 *
+	 * @tparam T 配置项类型
+	 */
+	template <typename T>
+		class Tunable {
+			public:
+				Tunable(T v = T()) : value(v) {}
+				Tunable(const Tunable& other) : value(other.load()) {}
+
+				Tunable& operator=(const Tunable& other) {
+					store(other.load());
+					return *this;
+				}
+				Tunable& operator=(T v) {
+					store(v);
+					return *this;
+				}
+
+				operator T() const {
+					return load();
+				}
+
+				T load() const {
+					return value.load(std::memory_order_relaxed);
+				}
+				void store(T v) {
+					value.store(v, std::memory_order_relaxed);
+				}
+
+			private:
+				std::atomic<T> value;
+		};
+
+	/**
+	 * @brief 调度器配置，每个调度器独立持有一份
+	 *
+	 * 默认值取自Runtime中的全局设置(Runtime::Default_config)；
+	 * cpus 只在 start 之前设置，其余各项可在运行中修改
+	 */
+	struct Sched_config {
+		Tunable<uint16_t> gc_threshold;			// gc阈值
+		Tunable<float>	  load_balance_rate;	// 负载均衡比例
+		Tunable<uint16_t> max_blocking_threads;	// 阻塞调用线程池的线程数上限
+		Tunable<uint32_t> block_threshold;		// 判定执行器阻塞的协程运行时间(微秒)
+		Tunable<uint32_t> time_slice;			// 抢占时间片(微秒)，0 表示不抢占
+		Tunable<uint32_t> scale_depth;			// 扩容阈值：平均每个执行器的可执行协程数
+		Tunable<uint32_t> scale_latency;		// 扩容阈值：排队协程的等待时间(微秒)
+		Tunable<uint32_t> idle_timeout;			// 回收空闲执行器的时间(微秒)
+		std::vector<int>  cpus;					// 执行器线程绑定的CPU集合，为空时不绑定
+		Tunable<core::Stack_mode> stack_mode;	// 协程栈的默认分配方式(创建协程时未指定时使用)
+		Tunable<std::size_t>	  max_stack_size;// eGrowable 栈可扩展到的大小
+		Tunable<Placement>		  placement;	// 新协程的放置策略
+	};
+
+}
@@ -0,0 +1,300 @@
+#include "cpu_profile.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include <sys/time.h>
+#include <ucontext.h>
+
+#include "../core/stack.h"
+#include "../task/stack_profile.h"
+#include "processor.h"
+
+// 每个样本最多回溯的层数
+#define PROFILE_MAX_DEPTH 64
+
+namespace {
+	/**
+	 * @brief 样本被中断的位置
+	 */
+	enum class Sample_kind : uint8_t {
+		eTask,		// 协程中(有栈协程的栈上，或运行中的无栈协程)
+		eScheduler,	// 执行器线程的调度栈上
+		eThread		// 其他线程
+	};
+
+	struct Sample {
+		std::atomic<bool> ready;	// 信号处理函数已写完
+		Sample_kind	kind;
+		uint32_t	depth;
+		uint64_t	task;
+		const void*	site;
+		void*		frames[PROFILE_MAX_DEPTH];
+	};
+
+	struct Profile_state {
+		std::mutex	mutex;		// Start/Stop/Dump/Reset
+		std::unique_ptr<Sample[]> samples;
+		size_t		capacity = 0;
+
+		std::atomic<uint64_t> next{0};
+		std::atomic<uint64_t> dropped{0};
+
+		bool		installed = false;	// 已安装 SIGPROF 处理函数(之后不再卸载)
+	};
+
+	Profile_state& State() {
+		RCO_STATIC Profile_state s_state;
+		return s_state;
+	}
+
+	/**
+	 * @brief 从信号的上下文中获取被中断的位置
+	 */
+	bool Interrupted_frame(void* uctx, void** pc, void** fp, uintptr_t* sp) {
+		ucontext_t* uc = static_cast<ucontext_t*>(uctx);
+#if defined(__linux__) && defined(__x86_64__)
+		*pc = (void*)uc->uc_mcontext.gregs[REG_RIP];
+		*fp = (void*)uc->uc_mcontext.gregs[REG_RBP];
+		*sp = (uintptr_t)uc->uc_mcontext.gregs[REG_RSP];
+		return true;
+#elif defined(__linux__) && defined(__aarch64__)
+		*pc = (void*)uc->uc_mcontext.pc;
+		*fp = (void*)uc->uc_mcontext.regs[29];
+		*sp = (uintptr_t)uc->uc_mcontext.sp;
+		return true;
+#else
+		(void)uc;
+		(void)pc;
+		(void)fp;
+		(void)sp;
+		return false;
+#endif
+	}
+
+	/**
+	 * @brief 函数名(去掉偏移)，折叠栈中 ';' 为分隔符
+	 */
+	std::string Frame_name(const void* addr) {
+		std::string name = rco::Symbolize(addr);
+		std::string::size_type pos = name.rfind("+0x");
+		if(pos != std::string::npos && pos > 0) {
+			name.resize(pos);
+		}
+		for(char& c : name) {
+			if(c == ';') {
+				c = ':';
+			}
+		}
+		return name;
+	}
+}
+
+std::atomic<bool> rco::Cpu_profile::enabled(false);
+RCO_CONSTEXPR int rco::Cpu_profile::kMaxHz;
+
+bool rco::Cpu_profile::Start(int hz, size_t capacity) {
+	Profile_state& state = State();
+	std::unique_lock<std::mutex> scope_lock(state.mutex);
+	if(enabled) {
+		return false;
+	}
+
+	if(!capacity) {
+		capacity = 1;
+	}
+	if(state.capacity != capacity) {
+		state.samples.reset(new Sample[capacity]);
+		state.capacity = capacity;
+	}
+	for(size_t i = 0; i < capacity; ++i) {
+		state.samples[i].ready.store(false, std::memory_order_relaxed);
+	}
+	state.next = 0;
+	state.dropped = 0;
+
+	if(!state.installed) {
+		struct sigaction sa;
+		std::memset(&sa, 0, sizeof(sa));
+		sa.sa_sigaction = &Cpu_profile::OnProfSignal;
+		// 协程栈较小，在执行器线程的信号栈上处理
+		sa.sa_flags = SA_SIGINFO | SA_RESTART | SA_ONSTACK;
+		sigemptyset(&sa.sa_mask);
+		sigaction(SIGPROF, &sa, nullptr);
+		state.installed = true;
+	}
+
+	enabled = true;
+
+	if(hz <= 0) {
+		hz = 99;
+	}
+	// 频率过高时间隔为 0，会使定时器停止
+	if(hz > kMaxHz) {
+		hz = kMaxHz;
+	}
+	struct itimerval timer;
+	timer.it_interval.tv_sec = 0;
+	timer.it_interval.tv_usec = 1000000 / hz;
+	timer.it_value = timer.it_interval;
+	setitimer(ITIMER_PROF, &timer, nullptr);
+	return true;
+}
+
+void rco::Cpu_profile::Stop() {
+	Profile_state& state = State();
+	std::unique_lock<std::mutex> scope_lock(state.mutex);
+	if(!enabled) {
+		return;
+	}
+
+	struct itimerval timer;
+	std::memset(&timer, 0, sizeof(timer));
+	setitimer(ITIMER_PROF, &timer, nullptr);
+
+	// 不恢复之前的处理函数：已经发出、尚未递送的 SIGPROF 在默认处理下会终止进程，
+	// 处理函数在停止后直接返回
+	enabled = false;
+}
+
+void rco::Cpu_profile::OnProfSignal(int, siginfo_t*, void* uctx) {
+	if(!Enabled()) {
+		return;
+	}
+
+	Profile_state& state = State();
+	uint64_t index = state.next.fetch_add(1, std::memory_order_relaxed);
+	if(index >= state.capacity) {
+		state.dropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	int saved_errno = errno;
+	Sample& sample = state.samples[index];
+
+	void* pc = nullptr;
+	void* fp = nullptr;
+	uintptr_t sp = 0;
+	bool has_frame = Interrupted_frame(uctx, &pc, &fp, &sp);
+
+	Task* task = Processor::CurrentTask();
+	uintptr_t low = 0;
+	uintptr_t high = 0;
+	if(task && task->on_stack() && task->stack_range(low, high) && sp >= low && sp < high) {
+		// 在协程栈上，沿帧指针回溯到协程入口
+		sample.kind = Sample_kind::eTask;
+		sample.task = task->id();
+		sample.site = task->spawn_site();
+		sample.depth = has_frame ? core::stack_walk(pc, fp, sp, high, sample.frames, PROFILE_MAX_DEPTH) : 0;
+	} else {
+		// 栈的范围未知，只记录被中断的位置；无栈协程在调度栈上运行，仍计入该协程
+		if(task && task->stackless()) {
+			sample.kind = Sample_kind::eTask;
+			sample.task = task->id();
+			sample.site = task->spawn_site();
+		} else {
+			sample.kind = Processor::CurrentProcessor() ? Sample_kind::eScheduler : Sample_kind::eThread;
+			sample.task = 0;
+			sample.site = nullptr;
+		}
+		sample.depth = has_frame ? 1 : 0;
+		sample.frames[0] = pc;
+	}
+
+	sample.ready.store(true, std::memory_order_release);
+	errno = saved_errno;
+}
+
+void rco::Cpu_profile::Dump(std::ostream& os, bool by_task) {
+	Profile_state& state = State();
+	std::unique_lock<std::mutex> scope_lock(state.mutex);
+
+	uint64_t count = state.next.load(std::memory_order_acquire);
+	if(count > state.capacity) {
+		count = state.capacity;
+	}
+
+	std::unordered_map<const void*, std::string> names;
+	auto name_of = [&](const void* addr) -> const std::string& {
+		auto it = names.find(addr);
+		if(it == names.end()) {
+			it = names.emplace(addr, Frame_name(addr)).first;
+		}
+		return it->second;
+	};
+
+	// 折叠栈按字典序输出
+	std::map<std::string, uint64_t> stacks;
+	for(uint64_t i = 0; i < count; ++i) {
+		const Sample& sample = state.samples[i];
+		if(!sample.ready.load(std::memory_order_acquire)) {
+			continue;
+		}
+
+		std::string line;
+		switch(sample.kind) {
+			case Sample_kind::eTask:
+				if(by_task) {
+					line = "task " + std::to_string(sample.task >> 48) + ":"
+						+ std::to_string(sample.task & ((1ull << 48) - 1)) + " ";
+				}
+				line += "spawned at " + Symbolize(sample.site);
+				break;
+			case Sample_kind::eScheduler:
+				line = "[scheduler]";
+				break;
+			case Sample_kind::eThread:
+				line = "[thread]";
+				break;
+		}
+
+		// 由外向内
+		for(uint32_t d = sample.depth; d > 0; --d) {
+			line += ";";
+			line += name_of(sample.frames[d - 1]);
+		}
+		++stacks[line];
+	}
+
+	for(auto& it : stacks) {
+		os << it.first << " " << it.second << "\n";
+	}
+	os.flush();
+}
+
+bool rco::Cpu_profile::Dump(const std::string& path, bool by_task) {
+	std::ofstream ofs(path);
+	if(!ofs) {
+		return false;
+	}
+	Dump(ofs, by_task);
+	return !!ofs;
+}
+
+uint64_t rco::Cpu_profile::Samples() {
+	Profile_state& state = State();
+	uint64_t count = state.next.load(std::memory_order_relaxed);
+	return count > state.capacity ? state.capacity : count;
+}
+
+uint64_t rco::Cpu_profile::Dropped() {
+	return State().dropped.load(std::memory_order_relaxed);
+}
+
+void rco::Cpu_profile::Reset() {
+	Profile_state& state = State();
+	std::unique_lock<std::mutex> scope_lock(state.mutex);
+	if(enabled) {
+		return;
+	}
+	for(size_t i = 0; i < state.capacity; ++i) {
+		state.samples[i].ready.store(false, std::memory_order_relaxed);
+	}
+	state.next = 0;
+	state.dropped = 0;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#include "../common/internal.h"
+
+namespace rco {
+
+	/**
+	 * @brief 按协程统计的 CPU 采样
+	 *
+	 * 开启后由 ITIMER_PROF 定时发送 SIGPROF，信号处理函数记录被中断的协程id、创建位置与调用栈
+	 * (沿帧指针回溯，需要以 -fno-omit-frame-pointer 编译)，样本写入预先分配的缓冲区，写满后丢弃；
+	 * 不在协程栈上的样本(调度、其他线程)只记录被中断的位置；输出时解析函数名需要导出符号(-rdynamic / ENABLE_EXPORTS)。
+	 * 输出为折叠栈格式(flamegraph.pl / speedscope / inferno 可直接读取)，根为协程的创建位置
+	 */
+	class Cpu_profile {
+		public:
+			Cpu_profile() = delete;
+
+			// 最高采样频率，定时器间隔不小于 100 微秒
+			RCO_STATIC RCO_CONSTEXPR int kMaxHz = 10000;
+
+			/**
+			 * @brief 开始采样，清空之前的样本
+			 *
+			 * @param[in] hz	   每秒采样次数(按进程的 CPU 时间)，不大于 0 时为 99，超过 kMaxHz 时按 kMaxHz
+			 * @param[in] capacity 最多保留的样本数
+			 *
+			 * @return 已经在采样 ? false : true
+			 */
+			RCO_STATIC bool Start(int hz = 99, size_t capacity = 1 << 14);
+
+			/**
+			 * @brief 停止采样，样本保留到下一次 Start/Reset；SIGPROF 处理函数保持安装(停止后忽略信号)
+			 */
+			RCO_STATIC void Stop();
+
+			RCO_STATIC RCO_INLINE bool Enabled() {
+				return enabled.load(std::memory_order_relaxed);
+			}
+
+			/**
+			 * @brief 输出折叠栈，每行为 "根;外层函数;...;内层函数 样本数"
+			 *
+			 * @param[in] os	  输出流
+			 * @param[in] by_task 根是否包含协程id(按单个协程统计)，否则只按创建位置汇总
+			 */
+			RCO_STATIC void Dump(std::ostream& os, bool by_task = false);
+
+			/**
+			 * @brief 输出折叠栈到文件
+			 *
+			 * @param[in] path	  文件路径
+			 * @param[in] by_task 根是否包含协程id
+			 *
+			 * @return 成功 ? true : false
+			 */
+			RCO_STATIC bool Dump(const std::string& path, bool by_task = false);
+
+			/**
+			 * @brief 已记录的样本数
+			 */
+			RCO_STATIC uint64_t Samples();
+
+			/**
+			 * @brief 缓冲区写满后丢弃的样本数
+			 */
+			RCO_STATIC uint64_t Dropped();
+
+			/**
+			 * @brief 清空样本(需先停止采样)
+			 */
+			RCO_STATIC void Reset();
+
+		private:
+			/**
+			 * @brief SIGPROF 处理函数，运行在执行器线程的信号栈上
+			 */
+			RCO_STATIC void OnProfSignal(int sig, siginfo_t* info, void* uctx);
+
+		private:
+			RCO_STATIC std::atomic<bool> enabled;
+	};
+}
@@ -0,0 +1,48 @@
+#include "introspect.h"
+
+#include "../task/stack_profile.h"
+
+const char* rco::Where_name(Task_info::Where where) {
+	switch(where) {
+		case Task_info::Where::eRunning:
+			return "running";
+		case Task_info::Where::eRunnable:
+			return "runnable";
+		case Task_info::Where::eReady:
+			return "ready";
+		case Task_info::Where::eWaiting:
+			return "waiting";
+	}
+	return "unknown";
+}
+
+void rco::Dump_tasks(std::ostream& os, const std::vector<Task_info>& tasks) {
+	os << "rco: " << tasks.size() << " live tasks\n";
+
+	bool first = true;
+	uint32_t proc = 0;
+	for(const Task_info& info : tasks) {
+		// 快照按执行器排列
+		if(first || info.proc != proc) {
+			first = false;
+			proc = info.proc;
+			os << "processor " << proc << ":\n";
+		}
+
+		os << "  task " << (info.id >> 48) << ":" << (info.id & ((1ull << 48) - 1))
+		   << " " << Where_name(info.where);
+		if(info.where == Task_info::Where::eWaiting) {
+			os << " (" << (info.wait_reason ? info.wait_reason : "park") << ")";
+		}
+		if(!info.started) {
+			os << " not started";
+		}
+		os << " idle=" << info.idle_us / 1000 << "ms"
+		   << " spawned at " << Symbolize(info.spawn_site) << "\n";
+
+		for(size_t i = 0; i < info.frames.size(); ++i) {
+			os << "      #" << i << " " << Symbolize(info.frames[i]) << "\n";
+		}
+	}
+	os.flush();
+}
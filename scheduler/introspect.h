@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include "../common/internal.h"
+
+namespace rco {
+
+	/**
+	 * @brief 协程快照(用于排查卡住的服务与泄漏的协程)
+	 */
+	struct Task_info {
+		/**
+		 * @brief 协程所处的位置
+		 */
+		enum class Where {
+			eRunning,	// 正在执行器上运行
+			eRunnable,	// 可执行队列中，等待运行
+			eReady,		// 就绪队列中，尚未被执行器取出
+			eWaiting,	// 挂起(CoPark)，等待唤醒
+		};
+
+		uint64_t	id;
+		uint32_t	proc;			// 执行器id
+		Where		where;
+		bool		started;		// 是否运行过(已分配栈)
+		const char* wait_reason;	// 挂起原因(仅 eWaiting)
+		uint64_t	idle_us;		// 距最近一次切出(或创建)的时间，精度为一个调度周期
+		const void* spawn_site;		// 创建协程的代码地址
+		std::vector<void*> frames;	// 切出位置的调用栈(正在运行或未运行过的协程为空)
+	};
+
+	/**
+	 * @brief 输出协程快照，调用栈解析为 函数名+偏移(需要 -rdynamic 导出符号)
+	 *
+	 * @param[in] os	输出流
+	 * @param[in] tasks 快照
+	 */
+	void Dump_tasks(std::ostream& os, const std::vector<Task_info>& tasks);
+
+	/**
+	 * @brief 协程位置的名称
+	 */
+	const char* Where_name(Task_info::Where where);
+}
@@ -0,0 +1,206 @@
+#include "metrics.h"
+
+#include <cstdio>
+#include <sstream>
+
+std::atomic<bool> rco::Metrics::timing(false);
+
+void rco::Metrics::Enable_timing(bool on) {
+	timing = on;
+}
+
+rco::Histogram::Histogram()
+	: count(0)
+	  , sum(0) {
+		  for(int i = 0; i < kBuckets; ++i) {
+			  buckets[i] = 0;
+		  }
+	  }
+
+void rco::Histogram::record(uint64_t ns) {
+	// 小于 1024ns 的落在第0个桶，之后每个桶的上界翻倍
+	uint64_t high = ns >> 10;
+	int index = high ? 64 - __builtin_clzll(high) : 0;
+	if(index >= kBuckets) {
+		index = kBuckets - 1;
+	}
+
+	Proc_metrics::Add(buckets[index]);
+	Proc_metrics::Add(count);
+	Proc_metrics::Add(sum, ns);
+}
+
+uint64_t rco::Histogram_stats::quantile(double q) const {
+	if(!count) {
+		return 0;
+	}
+
+	uint64_t target = (uint64_t)(q * count);
+	uint64_t seen = 0;
+	for(int i = 0; i < Histogram::kBuckets; ++i) {
+		seen += buckets[i];
+		if(seen > target) {
+			return Histogram::Bound(i);
+		}
+	}
+	return Histogram::Bound(Histogram::kBuckets - 1);
+}
+
+rco::Proc_metrics::Proc_metrics()
+	: spawned(0)
+	  , started(0)
+	  , finished(0)
+	  , parks(0)
+	  , park_ns(0)
+	  , steals_in(0)
+	  , steals_out(0)
+	  , idle_count(0)
+	  , idle_ns(0) {
+
+	  }
+
+namespace {
+	/**
+	 * @brief 输出一个计数器(每个执行器一个样本)
+	 */
+	template <typename Get>
+		void Prometheus_counter(std::ostringstream& os, const rco::Sched_stats& stats,
+				const char* name, const char* type, const char* help, Get get) {
+			os << "# HELP " << name << " " << help << "\n";
+			os << "# TYPE " << name << " " << type << "\n";
+			for(const rco::Proc_stats& p : stats.processors) {
+				os << name << "{sched=\"" << stats.sched_id << "\",proc=\"" << p.id << "\"} " << get(p) << "\n";
+			}
+		}
+
+	/**
+	 * @brief 输出一个直方图(累计桶，单位为秒)
+	 */
+	void Prometheus_histogram(std::ostringstream& os, const rco::Sched_stats& stats, const char* name,
+			const char* help, rco::Histogram_stats rco::Proc_stats::* member) {
+		os << "# HELP " << name << " " << help << "\n";
+		os << "# TYPE " << name << " histogram\n";
+		for(const rco::Proc_stats& p : stats.processors) {
+			const rco::Histogram_stats& h = p.*member;
+			char labels[64];
+			snprintf(labels, sizeof(labels), "sched=\"%u\",proc=\"%u\"", (unsigned)stats.sched_id, p.id);
+
+			uint64_t cumulative = 0;
+			for(int i = 0; i < rco::Histogram::kBuckets - 1; ++i) {
+				cumulative += h.buckets[i];
+				os << name << "_bucket{" << labels << ",le=\"" << rco::Histogram::Bound(i) / 1e9 << "\"} " << cumulative << "\n";
+			}
+			os << name << "_bucket{" << labels << ",le=\"+Inf\"} " << h.count << "\n";
+			os << name << "_sum{" << labels << "} " << h.sum / 1e9 << "\n";
+			os << name << "_count{" << labels << "} " << h.count << "\n";
+		}
+	}
+
+	void Json_histogram(std::ostringstream& os, const rco::Histogram_stats& h) {
+		os << "{\"count\":" << h.count << ",\"sum_ns\":" << h.sum
+		   << ",\"p50_ns\":" << h.quantile(0.5) << ",\"p99_ns\":" << h.quantile(0.99)
+		   << ",\"buckets\":[";
+		for(int i = 0; i < rco::Histogram::kBuckets; ++i) {
+			os << (i ? "," : "") << h.buckets[i];
+		}
+		os << "]}";
+	}
+}
+
+std::string rco::Sched_stats::to_prometheus() const {
+	std::ostringstream os;
+
+	os << "# HELP rco_tasks_alive Tasks created and not released yet.\n";
+	os << "# TYPE rco_tasks_alive gauge\n";
+	os << "rco_tasks_alive{sched=\"" << sched_id << "\"} " << tasks_alive << "\n";
+	os << "# HELP rco_tasks_unfinished Tasks not finished yet.\n";
+	os << "# TYPE rco_tasks_unfinished gauge\n";
+	os << "rco_tasks_unfinished{sched=\"" << sched_id << "\"} " << tasks_unfinished << "\n";
+
+	Prometheus_counter(os, *this, "rco_processor_active", "gauge", "Processor is active (1) or retired/blocked (0).",
+			[](const Proc_stats& p) { return p.active ? 1 : 0; });
+	Prometheus_counter(os, *this, "rco_processor_blocked", "gauge", "Processor is blocked by a long running task.",
+			[](const Proc_stats& p) { return p.blocked ? 1 : 0; });
+	Prometheus_counter(os, *this, "rco_context_switches_total", "counter", "Task switches on the processor.",
+			[](const Proc_stats& p) { return p.switches; });
+	Prometheus_counter(os, *this, "rco_tasks_spawned_total", "counter", "Tasks spawned by tasks running on the processor.",
+			[](const Proc_stats& p) { return p.spawned; });
+	Prometheus_counter(os, *this, "rco_tasks_started_total", "counter", "Tasks that first ran on the processor.",
+			[](const Proc_stats& p) { return p.started; });
+	Prometheus_counter(os, *this, "rco_tasks_finished_total", "counter", "Tasks that finished on the processor.",
+			[](const Proc_stats& p) { return p.finished; });
+	Prometheus_counter(os, *this, "rco_task_parks_total", "counter", "Task parks (CoPark).",
+			[](const Proc_stats& p) { return p.parks; });
+	Prometheus_counter(os, *this, "rco_task_parked_seconds_total", "counter", "Time tasks spent parked before resuming on the processor.",
+			[](const Proc_stats& p) { return p.park_ns / 1e9; });
+	Prometheus_counter(os, *this, "rco_steals_in_total", "counter", "Tasks moved to the processor by load balancing.",
+			[](const Proc_stats& p) { return p.steals_in; });
+	Prometheus_counter(os, *this, "rco_steals_out_total", "counter", "Tasks moved away from the processor by load balancing.",
+			[](const Proc_stats& p) { return p.steals_out; });
+	Prometheus_counter(os, *this, "rco_processor_idle_total", "counter", "Times the processor waited for work.",
+			[](const Proc_stats& p) { return p.idle_count; });
+	Prometheus_counter(os, *this, "rco_processor_idle_seconds_total", "counter", "Time the processor spent waiting for work.",
+			[](const Proc_stats& p) { return p.idle_ns / 1e9; });
+	Prometheus_counter(os, *this, "rco_queue_runnable", "gauge", "Tasks in the runnable queue.",
+			[](const Proc_stats& p) { return p.runnable; });
+	Prometheus_counter(os, *this, "rco_queue_ready", "gauge", "Tasks in the ready queue.",
+			[](const Proc_stats& p) { return p.ready; });
+	Prometheus_counter(os, *this, "rco_queue_waiting", "gauge", "Parked tasks.",
+			[](const Proc_stats& p) { return p.waiting; });
+	Prometheus_counter(os, *this, "rco_processor_load", "gauge", "Moving average of runnable tasks on the processor.",
+			[](const Proc_stats& p) { return p.load_avg; });
+	Prometheus_counter(os, *this, "rco_processor_busy_ratio", "gauge", "Moving average of the fraction of time the processor is busy.",
+			[](const Proc_stats& p) { return p.busy_avg; });
+
+	if(timing) {
+		Prometheus_histogram(os, *this, "rco_task_run_seconds", "Time a task runs before switching out.",
+				&Proc_stats::run_time);
+		Prometheus_histogram(os, *this, "rco_task_wake_latency_seconds", "Time from CoWake until the task runs.",
+				&Proc_stats::wake_latency);
+	}
+	return os.str();
+}
+
+std::string rco::Sched_stats::to_json() const {
+	std::ostringstream os;
+
+	os << "{\"sched_id\":" << sched_id
+	   << ",\"tasks_alive\":" << tasks_alive
+	   << ",\"tasks_unfinished\":" << tasks_unfinished
+	   << ",\"timing\":" << (timing ? "true" : "false")
+	   << ",\"histogram_bucket_bound_ns\":[";
+	for(int i = 0; i < Histogram::kBuckets - 1; ++i) {
+		os << (i ? "," : "") << Histogram::Bound(i);
+	}
+	os << "],\"processors\":[";
+
+	for(std::size_t i = 0; i < processors.size(); ++i) {
+		const Proc_stats& p = processors[i];
+		os << (i ? "," : "")
+		   << "{\"id\":" << p.id
+		   << ",\"active\":" << (p.active ? "true" : "false")
+		   << ",\"blocked\":" << (p.blocked ? "true" : "false")
+		   << ",\"switches\":" << p.switches
+		   << ",\"spawned\":" << p.spawned
+		   << ",\"started\":" << p.started
+		   << ",\"finished\":" << p.finished
+		   << ",\"parks\":" << p.parks
+		   << ",\"park_ns\":" << p.park_ns
+		   << ",\"steals_in\":" << p.steals_in
+		   << ",\"steals_out\":" << p.steals_out
+		   << ",\"idle_count\":" << p.idle_count
+		   << ",\"idle_ns\":" << p.idle_ns
+		   << ",\"runnable\":" << p.runnable
+		   << ",\"ready\":" << p.ready
+		   << ",\"waiting\":" << p.waiting
+		   << ",\"load_avg\":" << p.load_avg
+		   << ",\"busy_avg\":" << p.busy_avg
+		   << ",\"run_time\":";
+		Json_histogram(os, p.run_time);
+		os << ",\"wake_latency\":";
+		Json_histogram(os, p.wake_latency);
+		os << "}";
+	}
+	os << "]}";
+	return os.str();
+}
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../common/internal.h"
+
+namespace rco {
+
+	/**
+	 * @brief 耗时直方图(无锁)，桶按 2 的幂划分：第 i 个桶的上界为 1024 << i 纳秒，最后一个桶没有上界
+	 *
+	 * 只允许一个线程写入(所属执行器线程)，可在任意线程读取
+	 */
+	struct Histogram {
+		RCO_STATIC RCO_CONSTEXPR int kBuckets = 24;
+
+		Histogram();
+
+		/**
+		 * @brief 记录一次耗时
+		 *
+		 * @param[in] ns 纳秒
+		 */
+		void record(uint64_t ns);
+
+		/**
+		 * @brief 第 i 个桶的上界(纳秒)
+		 */
+		RCO_STATIC RCO_INLINE uint64_t Bound(int i) {
+			return 1024ull << i;
+		}
+
+		std::atomic<uint64_t> buckets[kBuckets];
+		std::atomic<uint64_t> count;
+		std::atomic<uint64_t> sum;		// 纳秒
+	};
+
+	/**
+	 * @brief 直方图快照
+	 */
+	struct Histogram_stats {
+		uint64_t buckets[Histogram::kBuckets];	// 各个桶的计数(非累计)
+		uint64_t count;
+		uint64_t sum;							// 纳秒
+
+		/**
+		 * @brief 估算分位数
+		 *
+		 * @param[in] q 分位(0 ~ 1)
+		 *
+		 * @return 所在桶的上界(纳秒)，没有数据时为0
+		 */
+		uint64_t quantile(double q) const;
+	};
+
+	/**
+	 * @brief 执行器的指标(无锁)
+	 *
+	 * 除偷取计数(由分发线程写入)外，其余字段只由执行器线程写入
+	 */
+	struct Proc_metrics {
+		Proc_metrics();
+
+		std::atomic<uint64_t> spawned;		// 在该执行器上的协程中创建的协程数
+		std::atomic<uint64_t> started;		// 第一次在该执行器上运行的协程数
+		std::atomic<uint64_t> finished;		// 在该执行器上结束的协程数
+		std::atomic<uint64_t> parks;		// 协程挂起次数(CoPark)
+		std::atomic<uint64_t> park_ns;		// 协程从挂起到恢复运行的总时间(需要开启耗时统计)
+		std::atomic<uint64_t> steals_in;	// 负载均衡移入的协程数
+		std::atomic<uint64_t> steals_out;	// 负载均衡移出的协程数
+		std::atomic<uint64_t> idle_count;	// 执行器进入等待的次数
+		std::atomic<uint64_t> idle_ns;		// 执行器等待协程的总时间
+
+		Histogram run_time;		// 协程每次运行(切入到切出)的时间
+		Histogram wake_latency;	// 协程从被唤醒(CoWake)到开始运行的时间
+
+		/**
+		 * @brief 单写者累加：只由执行器线程调用，不需要原子读改写
+		 */
+		RCO_STATIC RCO_INLINE void Add(std::atomic<uint64_t>& counter, uint64_t n = 1) {
+			counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+		}
+	};
+
+	/**
+	 * @brief 执行器指标快照
+	 */
+	struct Proc_stats {
+		uint32_t id;
+		bool	 active;
+		bool	 blocked;
+		uint64_t switches;		// 协程切换次数
+		uint64_t spawned;
+		uint64_t started;
+		uint64_t finished;
+		uint64_t parks;
+		uint64_t park_ns;
+		uint64_t steals_in;
+		uint64_t steals_out;
+		uint64_t idle_count;
+		uint64_t idle_ns;
+		uint64_t runnable;		// 可执行队列长度
+		uint64_t ready;			// 就绪队列长度
+		uint64_t waiting;		// 等待队列长度(挂起的协程)
+		double	 load_avg;		// 待执行协程数的指数移动平均
+		double	 busy_avg;		// 忙碌比例的指数移动平均(0 ~ 1)
+
+		Histogram_stats run_time;
+		Histogram_stats wake_latency;
+	};
+
+	/**
+	 * @brief 调度器指标快照(Runtime::Stats)
+	 */
+	struct Sched_stats {
+		uint16_t sched_id;
+		uint64_t tasks_alive;		// 存活(未释放)的协程数
+		uint64_t tasks_unfinished;	// 未执行完毕的协程数
+		bool	 timing;			// 是否记录了耗时直方图
+
+		std::vector<Proc_stats> processors;
+
+		/**
+		 * @brief 导出为 Prometheus 文本格式
+		 *
+		 * @return 文本
+		 */
+		std::string to_prometheus() const;
+
+		/**
+		 * @brief 导出为 JSON
+		 *
+		 * @return 文本
+		 */
+		std::string to_json() const;
+	};
+
+	/**
+	 * @brief 指标的全局设置
+	 */
+	class Metrics {
+		public:
+			Metrics() = delete;
+
+			/**
+			 * @brief 开启/关闭耗时统计(运行时间与唤醒延迟直方图)，开启后每次切换需要读取两次时钟
+			 *
+			 * @param[in] on 开启 ? true : false
+			 */
+			RCO_STATIC void Enable_timing(bool on);
+
+			RCO_STATIC RCO_INLINE bool Timing() {
+				return timing.load(std::memory_order_relaxed);
+			}
+
+			/**
+			 * @brief 单调时钟
+			 *
+			 * @return 纳秒
+			 */
+			RCO_STATIC RCO_INLINE uint64_t Now() {
+				return std::chrono::duration_cast<std::chrono::nanoseconds>(
+						std::chrono::steady_clock::now().time_since_epoch()).count();
+			}
+
+		private:
+			RCO_STATIC std::atomic<bool> timing;
+	};
+}
@@ -2,19 +2,101 @@
 
 #include "runtime.h"
 #include "scheduler.h"
+#include "../task/stack_profile.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <mutex>
+#include <stdexcept>
 #include <utility>
 
+#include <unistd.h>
+
+// 执行器线程的信号栈大小
+#define SIGNAL_STACK_SIZE (64 * 1024)
+
+// 每个执行器缓存的协程栈数
+#define STACK_CACHE_SIZE 64
+
+// 负载移动平均的衰减：每个调度周期向采样值靠近 1/2^LOAD_DECAY
+#define LOAD_DECAY 1
+
+namespace {
+	/**
+	 * @brief 执行器线程的信号栈，协程栈溢出时 SIGSEGV 处理函数无法在原栈上运行
+	 */
+	class Signal_stack {
+		public:
+			Signal_stack()
+				: memory(malloc(SIGNAL_STACK_SIZE)) {
+					stack_t ss;
+					ss.ss_sp = memory;
+					ss.ss_size = SIGNAL_STACK_SIZE;
+					ss.ss_flags = 0;
+					if(!memory || sigaltstack(&ss, &prev) != 0) {
+						prev.ss_flags = SS_DISABLE;
+					}
+				}
+
+			~Signal_stack() {
+				sigaltstack(&prev, nullptr);
+				free(memory);
+			}
+		private:
+			void*	memory;
+			stack_t prev;
+	};
+
+	struct sigaction s_prev_fault_action;
+
+	/**
+	 * @brief 异步信号安全地输出无符号整数
+	 */
+	void Write_number(uint64_t n, int base) {
+		char buf[24];
+		int pos = sizeof(buf);
+		do {
+			buf[--pos] = "0123456789abcdef"[n % base];
+			n /= base;
+		} while(n && pos > 0);
+		ssize_t ret = write(STDERR_FILENO, buf + pos, sizeof(buf) - pos);
+		(void)ret;
+	}
+
+	void Write_string(const char* str) {
+		ssize_t ret = write(STDERR_FILENO, str, strlen(str));
+		(void)ret;
+	}
+}
+
 rco::Processor::Processor(rco::Scheduler* scheduler, int id)
 	: own_scheduler(scheduler)
 	, thread_id(id)
 	, running_task(nullptr)
 	, next_task(nullptr)
+	, sched_ctx(nullptr, nullptr, 0)
+	, switch_locked(false)
+	, stack_cache(STACK_CACHE_SIZE)
 	, wait_flag(false)
 	, notified(false)
 	  , active(true)
+	  , blocked(false)
+	  , retiring(false)
+	  , retired(false)
+	  , idle_since(0)
 	  , quota(0)
-	  , gc_threshold(Runtime::GC_threshold()){
+	  , gc_threshold(scheduler->config.gc_threshold)
+	  , tag_tick(0)
+	  , tag_switch(0)
+	  , switch_count(0)
+	  , load_avg(0)
+	  , busy_avg(0)
+	  , run_since(0)
+	  , native_thread(pthread_self())
+	  , preempt_switch(0)
+	  , preempt_flag(0) {
 
 		  // 等待队列和运行队列使用同一个锁
 		  wait_queue.set_lock(&runnable_queue.lock_ref());
@@ -48,25 +130,313 @@ void rco::Processor::CoYield() {
 	}
 }
 
+void rco::Processor::CoPark(const std::function<void()>& on_parked, const char* reason) {
+	Processor* proc = CurrentProcessor();
+	Task* task = CurrentTask();
+
+	assert(task);
+	if(task->stackless()) {
+		throw std::logic_error("stackless task cannot park");
+	}
+
+	Proc_metrics::Add(proc->metrics.parks);
+	if(Metrics::Timing()) {
+		task->set_park_time(Metrics::Now());
+	}
+
+	// 更新协程状态，切出后放入等待队列
+	proc->park_hook = on_parked;
+	task->set_wait_reason(reason);
+	task->set_state(Task::State::eWait);
+	proc->switch_out(task);
+}
+
+void rco::Processor::CoWake(Task* task) {
+	Processor* proc = task->own_proc();
+
+	assert(proc);
+	proc->wake(task);
+}
+
+void rco::Processor::CoPreemptPoint() {
+	Processor* proc = CurrentProcessor();
+	if(proc && proc->preempt_flag) {
+		proc->preempt_flag = 0;
+		proc->coyield();
+	}
+}
+
+void rco::Processor::InstallPreemptHandler() {
+	RCO_STATIC std::once_flag s_once;
+	std::call_once(s_once, []{
+			struct sigaction sa;
+			std::memset(&sa, 0, sizeof(sa));
+			sa.sa_handler = &Processor::OnPreemptSignal;
+			// 协程可能在信号处理函数中切出，不屏蔽该信号以免影响其他协程的抢占
+			sa.sa_flags = SA_RESTART | SA_NODEFER;
+			sigemptyset(&sa.sa_mask);
+			sigaction(RCO_PREEMPT_SIGNAL, &sa, nullptr);
+			});
+}
+
+void rco::Processor::InstallFaultHandler() {
+	RCO_STATIC std::once_flag s_once;
+	std::call_once(s_once, []{
+			struct sigaction sa;
+			std::memset(&sa, 0, sizeof(sa));
+			sa.sa_sigaction = &Processor::OnFaultSignal;
+			sa.sa_flags = SA_SIGINFO | SA_ONSTACK;
+			sigemptyset(&sa.sa_mask);
+			sigaction(SIGSEGV, &sa, &s_prev_fault_action);
+			});
+}
+
+void rco::Processor::OnFaultSignal(int sig, siginfo_t* info, void* uctx) {
+	Task* task = CurrentTask();
+	if(task && task->on_stack()) {
+		switch(task->stack_fault(info->si_addr)) {
+			case core::Stack_fault::eGrown:
+				// 栈已扩展，返回后重新执行访问指令
+				return;
+			case core::Stack_fault::eOverflow:
+				Write_string("rco: stack overflow in task ");
+				Write_number(task->id(), 10);
+				Write_string(" (fault address 0x");
+				Write_number((uintptr_t)info->si_addr, 16);
+				Write_string(")\n");
+				break;
+			case core::Stack_fault::eNone:
+				break;
+		}
+	}
+
+	// 不是协程栈的异常，交给之前的处理函数
+	if((s_prev_fault_action.sa_flags & SA_SIGINFO) && s_prev_fault_action.sa_sigaction) {
+		s_prev_fault_action.sa_sigaction(sig, info, uctx);
+		return;
+	}
+	if(s_prev_fault_action.sa_handler != SIG_DFL && s_prev_fault_action.sa_handler != SIG_IGN) {
+		s_prev_fault_action.sa_handler(sig);
+		return;
+	}
+
+	// 恢复默认处理方式，返回后重新触发异常
+	signal(sig, SIG_DFL);
+}
+
+void rco::Processor::preempt() {
+	uint64_t count = switch_count;
+
+	// 同一次切换只请求一次抢占
+	if(preempt_switch == count) {
+		return;
+	}
+	preempt_switch = count;
+
+	pthread_kill(native_thread, RCO_PREEMPT_SIGNAL);
+}
+
+void rco::Processor::OnPreemptSignal(int) {
+	Processor* proc = CurrentProcessor();
+	if(!proc) {
+		return;
+	}
+
+	Task* task = proc->running_task;
+
+	// 信号到达前协程已经切出，或者线程不在协程栈上(执行器调度中或上下文切换中)
+	if(!task || proc->preempt_switch != proc->switch_count || !task->on_stack()) {
+		return;
+	}
+
+	if(task->preemptible()) {
+		int saved_errno = errno;
+		// 在信号处理函数中直接切出，恢复后从信号处理函数返回到被中断的位置
+		task->yield();
+		errno = saved_errno;
+	} else {
+		proc->preempt_flag = 1;
+	}
+}
+
+void rco::Processor::wake(Task* task) {
+	{
+		std::unique_lock<TaskQueue_ts::lock_t> scope_lock(wait_queue.lock_ref());
+
+		// 从等待队列中移除
+		if(!wait_queue.nolock_erase(task, true)) {
+			return;
+		}
+	}
+
+	RCO_TRACE_EVENT(eWake, task->id(), thread_id, 0);
+	if(Metrics::Timing()) {
+		task->set_wake_time(Metrics::Now());
+	}
+
+	// 交给调度器重新分配(所属执行器可能已经因阻塞而未激活)
+	own_scheduler->add_task(task);
+}
+
 void rco::Processor::coyield() {
 	Task* task = CurrentTask();
 
 	assert(task);
+	// 无栈协程不能切出，与 CoPark 一致，调试与发布版本都抛出异常
+	if(task->stackless()) {
+		throw std::logic_error("stackless task cannot yield");
+	}
 	// 协程切出
-	task->yield();
+	switch_out(task);
+}
+
+void rco::Processor::switch_out(Task* task) {
+	task->prepare_switch();
+
+	TaskQueue_ts::lock_t& lock = runnable_queue.lock_ref();
+	lock.lock();
+
+	// 下一个可执行的协程可以被直接切入时，不经过调度上下文
+	// 本轮可执行队列已经遍历完毕且没有就绪的协程时，从队首开始新的一轮；
+	// 否则回到调度上下文，由其合并就绪队列、进入等待
+	Task* next = static_cast<Task*>(task->next);
+	if(!next && ready_queue.empty()) {
+		runnable_queue.nolock_front(next);
+	}
+	bool direct = active && own_scheduler->running.load(std::memory_order_acquire);
+
+	// 只有当前协程可以运行，不需要切换
+	if(next == task && direct && task->state() == Task::State::eRunnable) {
+		finish_run(task);
+		prepare_resume(task);
+		lock.unlock();
+		task->cancel_switch();
+		return;
+	}
+
+	if(!next || next == task || !next->resumable_directly() || !direct) {
+		lock.unlock();
+		task->yield();
+
+		// 恢复时可能是由其他协程直接切入的
+		AfterSwitch();
+		return;
+	}
+
+	// 挂起的协程从可执行队列移入等待队列(两个队列使用同一个锁，引用计数不变)
+	if(task->state() == Task::State::eWait) {
+		if(runnable_queue.nolock_erase(task, true, false)) {
+			wait_queue.nolock_push(task, false);
+		}
+	}
+
+	running_task = next;
+	running_task->check = runnable_queue.check;
+	finish_run(task);
+	prepare_resume(next);
+
+	// 切换完成前持有队列锁：切出的协程不会被偷取或唤醒，由切入的一方解锁
+	switch_locked = true;
+	task->transfer(next);
+
+	AfterSwitch();
+}
+
+void rco::Processor::finish_run(Task* task) {
+#if defined(RCO_TRACE)
+	Trace::Emit(task->state() == Task::State::eFinish ? Trace_event::eFinish
+			: task->state() == Task::State::eWait ? Trace_event::ePark : Trace_event::eYield,
+			task->id(), thread_id);
+#endif
+	task->set_last_run(own_scheduler->tick);
+
+	if(Metrics::Timing() && run_since) {
+		metrics.run_time.record(Metrics::Now() - run_since);
+		run_since = 0;
+	}
+}
+
+void rco::Processor::AfterSwitch() {
+	Processor* proc = CurrentProcessor();
+	proc->unlock_switch();
+	proc->run_park_hook();
+}
+
+void rco::Processor::prepare_resume(Task* task) {
+	// 协程状态更新为运行中
+	task->set_state(Task::State::eRunnable);
+	// 第一次运行(尚未属于任何执行器)
+	if(!task->own_proc()) {
+		Proc_metrics::Add(metrics.started);
+	}
+	// 更新协程所属的执行器
+	task->set_own_proc(this);
+
+	// 第一次运行时才分配栈
+	if(!task->stack_ready()) {
+		task->acquire_stack(&stack_cache);
+	}
+
+	switch_count = switch_count + 1;
+	RCO_TRACE_EVENT(eResume, task->id(), thread_id, 0);
+	// 新的一次调度，清除上个协程遗留的抢占请求
+	preempt_flag = 0;
+
+	if(Metrics::Timing()) {
+		uint64_t now = Metrics::Now();
+		uint64_t woken = task->wake_time();
+		if(woken) {
+			metrics.wake_latency.record(now > woken ? now - woken : 0);
+			task->set_wake_time(0);
+		}
+		// 挂起的时长计入恢复运行的执行器
+		uint64_t parked = task->park_time();
+		if(parked) {
+			Proc_metrics::Add(metrics.park_ns, now > parked ? now - parked : 0);
+			task->set_park_time(0);
+		}
+		run_since = now;
+	}
+}
+
+void rco::Processor::unlock_switch() {
+	if(switch_locked) {
+		switch_locked = false;
+		runnable_queue.lock_ref().unlock();
+	}
 }
 
-size_t rco::Processor::runnable_count() {
-	// 可运行的协程数
-	// 可运行协程队列大小 + 就绪协程队列大小
-	// 当可运行协程队列中协程不够时，将会把就绪队列中的协程取出
-	// 因此可运行协程数 为 两个队列长度之和
-	return runnable_queue.size() + ready_queue.size();
+void rco::Processor::run_park_hook() {
+	if(park_hook) {
+		std::function<void()> hook;
+		hook.swap(park_hook);
+		hook();
+	}
 }
 
-void rco::Processor::add_task(Task* task) {
+void rco::Processor::update_load(size_t depth) {
+	// avg += (sample - avg) / 2^LOAD_DECAY，只有分发线程写入，不需要原子的读-改-写
+	auto decay = [](uint32_t avg, uint64_t sample) -> uint32_t {
+		int64_t diff = (int64_t)sample - (int64_t)avg;
+		return (uint32_t)((int64_t)avg + diff / (1 << LOAD_DECAY));
+	};
+
+	uint64_t depth_sample = std::min<uint64_t>(depth, UINT32_MAX >> kLoadShift) << kLoadShift;
+	// 忙碌比例按周期采样：采样时不在等待协程记为忙碌
+	uint64_t busy_sample = waiting() ? 0 : (1u << kLoadShift);
+
+	load_avg.store(decay(load_avg.load(std::memory_order_relaxed), depth_sample), std::memory_order_relaxed);
+	busy_avg.store(decay(busy_avg.load(std::memory_order_relaxed), busy_sample), std::memory_order_relaxed);
+}
+
+bool rco::Processor::add_task(Task* task) {
 	std::unique_lock<TaskQueue_ts::lock_t> scope_lock(ready_queue.lock_ref());
 
+	// 执行器已被回收，由调用者重新选择执行器
+	if(retired) {
+		return false;
+	}
+
 	// 放入就绪队列
 	ready_queue.nolock_push(task);
 
@@ -77,12 +447,17 @@ void rco::Processor::add_task(Task* task) {
 	} else {
 		notified = true;
 	}
+	return true;
 }
 
 // 与上面功能一致，只不过能一次添加多个协程
-void rco::Processor::add_task(TSList<Task> && list) {
+bool rco::Processor::add_task(TSList<Task> && list) {
 	std::unique_lock<TaskQueue_ts::lock_t> scope_lock(ready_queue.lock_ref());
 
+	if(retired) {
+		return false;
+	}
+
 	ready_queue.nolock_push(std::move(list));
 
 	if(wait_flag) {
@@ -90,13 +465,18 @@ void rco::Processor::add_task(TSList<Task> && list) {
 	} else {
 		notified = true;
 	}
+	return true;
 }
 
 void rco::Processor::scheduling() {
 	CurrentProcessor() = this;
+	native_thread = pthread_self();
+
+	// 协程栈溢出时在信号栈上报告
+	Signal_stack signal_stack;
 
 	// 所属调度器正在运行
-	while(own_scheduler->running) {
+	while(own_scheduler->running.load(std::memory_order_acquire)) {
 		// 从可运行队列中取出一个协程并开始执行
         runnable_queue.front(running_task);
 
@@ -112,6 +492,10 @@ void rco::Processor::scheduling() {
 				// 此时线程休眠，等待任务来临，唤醒
 				// 更新状态标志
 				wait_notify();
+				// 执行器已被回收，退出调度
+				if(retired) {
+					break;
+				}
 				// 再次尝试
 				readyToRunnable();
 				continue;
@@ -120,17 +504,21 @@ void rco::Processor::scheduling() {
 	
 		quota = 1;
 	
-		while(running_task && own_scheduler->running) {
+		while(running_task && own_scheduler->running.load(std::memory_order_acquire)) {
+
+			prepare_resume(running_task);
 
-			// 协程状态更新为运行中
-			running_task->set_state(Task::State::eRunnable);
-			// 更新协程所属的执行器
-			running_task->set_own_proc(this);
-			
-			++switch_count;
+			if(running_task->stackless()) {
+				// 无栈协程直接在调度栈上执行到结束
+				running_task->run_inline();
+			} else {
+				// 协程开始执行
+				running_task->resume(sched_ctx); // wait for until task execute finish
 
-			// 协程开始执行
-			running_task->resume(); // wait for until task execute finish
+				// 协程之间可能直接切换过，running_task为最后切出到调度上下文的协程
+				unlock_switch();
+			}
+			finish_run(running_task);
 
 			// 协程切出后，根据其状态作出处理
 			switch (running_task->state()) {
@@ -146,13 +534,33 @@ void rco::Processor::scheduling() {
 					state_finish();
 					break;
 			}
+
+			// 协程已切出，执行挂起回调
+			run_park_hook();
 		}
 
 	}
+
+	// 执行器可能在关闭后被释放，线程不再指向它
+	CurrentProcessor() = nullptr;
+
+	// 退出调度，之后添加协程将失败
+	std::unique_lock<TaskQueue_ts::lock_t> scope_lock(ready_queue.lock_ref());
+	retired = true;
 }
 
 bool rco::Processor::blocking() {
-	return false;
+	// 有协程在运行，且在阈值时间内协程切换次数没有变化
+	return running_time() >= own_scheduler->config.block_threshold;
+}
+
+uint64_t rco::Processor::running_time() {
+	// 切换次数与标记不一致，说明协程在本轮标记之后才切换，尚未计时
+	if(!running_task || tag_switch != switch_count) {
+		return 0;
+	}
+	uint64_t now = own_scheduler->tick;
+	return now > tag_tick ? now - tag_tick : 0;
 }
 
 void rco::Processor::readyToRunnable() {
@@ -188,12 +596,99 @@ void rco::Processor::wait_notify() {
 		notified = false;
 		return;
 	}
-	
+
+	// 执行器正在被回收，且没有新的协程，退出调度
+	// (在就绪队列锁内设置，之后添加协程将失败并由调度器重新选择执行器)
+	if(retiring && ready_queue.empty()) {
+		retired = true;
+		return;
+	}
+
+	idle_since = own_scheduler->tick;
+
 	// 更新等待标志
 	wait_flag = true;
+	uint64_t begin = Metrics::Now();
 	cv.wait(scope_lock);
 	// 等待结束更新标志
 	wait_flag = false;
+
+	Proc_metrics::Add(metrics.idle_count);
+	Proc_metrics::Add(metrics.idle_ns, Metrics::Now() - begin);
+}
+
+void rco::Processor::stats(Proc_stats& out) {
+	out.id = thread_id;
+	out.active = active;
+	out.blocked = blocked;
+	out.switches = switch_count;
+	out.spawned = metrics.spawned.load(std::memory_order_relaxed);
+	out.started = metrics.started.load(std::memory_order_relaxed);
+	out.finished = metrics.finished.load(std::memory_order_relaxed);
+	out.parks = metrics.parks.load(std::memory_order_relaxed);
+	out.park_ns = metrics.park_ns.load(std::memory_order_relaxed);
+	out.steals_in = metrics.steals_in.load(std::memory_order_relaxed);
+	out.steals_out = metrics.steals_out.load(std::memory_order_relaxed);
+	out.idle_count = metrics.idle_count.load(std::memory_order_relaxed);
+	out.idle_ns = metrics.idle_ns.load(std::memory_order_relaxed);
+
+	out.ready = ready_queue.size();
+	out.runnable = runnable_queue.size();
+	out.waiting = wait_queue.size();
+	out.load_avg = (double)load_average() / (1u << kLoadShift);
+	out.busy_avg = (double)busy_average() / (1u << kLoadShift);
+
+	const Histogram* src[2] = { &metrics.run_time, &metrics.wake_latency };
+	Histogram_stats* dst[2] = { &out.run_time, &out.wake_latency };
+	for(int k = 0; k < 2; ++k) {
+		for(int i = 0; i < Histogram::kBuckets; ++i) {
+			dst[k]->buckets[i] = src[k]->buckets[i].load(std::memory_order_relaxed);
+		}
+		dst[k]->count = src[k]->count.load(std::memory_order_relaxed);
+		dst[k]->sum = src[k]->sum.load(std::memory_order_relaxed);
+	}
+}
+
+void rco::Processor::tasks(std::vector<Task_info>& out, size_t max_frames) {
+	uint64_t now = own_scheduler->tick;
+	std::vector<void*> frames(max_frames);
+
+	auto snapshot = [&](Task* task, Task_info::Where where) {
+		Task_info info;
+		info.id = task->id();
+		info.proc = thread_id;
+		info.where = where;
+		info.started = task->stack_ready();
+		info.wait_reason = where == Task_info::Where::eWaiting ? task->wait_reason() : nullptr;
+		info.idle_us = now > task->last_run_tick() ? now - task->last_run_tick() : 0;
+		info.spawn_site = task->spawn_site();
+		// 正在运行的协程的上下文尚未保存
+		if(where != Task_info::Where::eRunning && max_frames) {
+			size_t n = task->backtrace(frames.data(), max_frames);
+			info.frames.assign(frames.begin(), frames.begin() + n);
+		}
+		out.push_back(std::move(info));
+	};
+
+	{
+		// 可执行队列与等待队列使用同一个锁，持有锁时协程不会结束或被偷取
+		std::unique_lock<TaskQueue_ts::lock_t> scope_lock(runnable_queue.lock_ref());
+		Task* task = nullptr;
+		for(runnable_queue.nolock_front(task); task; runnable_queue.nolock_next(task, task)) {
+			// 正在运行的协程可能正在挂起或结束(状态已改变但上下文尚未保存)，
+			// 只按锁内读取的 running_task 判断，不读取其状态
+			snapshot(task, task == running_task ? Task_info::Where::eRunning : Task_info::Where::eRunnable);
+		}
+		for(wait_queue.nolock_front(task); task; wait_queue.nolock_next(task, task)) {
+			snapshot(task, Task_info::Where::eWaiting);
+		}
+	}
+
+	std::unique_lock<TaskQueue_ts::lock_t> scope_lock(ready_queue.lock_ref());
+	Task* task = nullptr;
+	for(ready_queue.nolock_front(task); task; ready_queue.nolock_next(task, task)) {
+		snapshot(task, Task_info::Where::eReady);
+	}
 }
 
 void rco::Processor::gc() {
@@ -280,8 +775,8 @@ rco::TSList<rco::Task> rco::Processor::steal(std::size_t n) {
         }
         // 以上两步是为了保证 可执行协程 与 下一个可执行协程 不被取出
 
-        // 从可执行协程队列中取出 n-list.size() 个协程(即：补够缺少的协程个数)
-        TSList<Task> target_list = runnable_queue.nolock_trunc_back(n - list.size());
+        // 取出可执行协程队列中剩余的全部协程
+        TSList<Task> target_list = runnable_queue.nolock_pop_all();
 
         // 如果可执行协程删除成功
         if(push_sate.first) {
@@ -340,7 +835,20 @@ bool rco::Processor::state_runnable() {
 void rco::Processor::state_wait() {
 	std::unique_lock<TaskQueue_ts::lock_t> scope_lock(runnable_queue.lock_ref());
 
-	running_task = next_task;
+	Task* task = running_task;
+
+	// 下一个可执行的协程
+	Task* next = static_cast<Task*>(task->next);
+
+	// 从可执行队列移入等待队列(两个队列使用同一个锁，引用计数不变)
+	if(runnable_queue.nolock_erase(task, true, false)) {
+		wait_queue.nolock_push(task, false);
+	}
+
+	running_task = next;
+	if(running_task) {
+		running_task->check = runnable_queue.check;
+	}
 	next_task = nullptr;
 }
 
@@ -358,6 +866,16 @@ void rco::Processor::state_finish() {
 
 	runnable_queue.erase(running_task);
 
+	// 未完成的协程数减少
+	own_scheduler->task_finished();
+	Proc_metrics::Add(metrics.finished);
+
+	// 协程已结束，立即归还栈，不等待gc
+	if(Stack_profile::Enabled()) {
+		Stack_profile::Record(*running_task);
+	}
+	running_task->release_stack(&stack_cache);
+
 	// 如果垃圾回收队列大小 大于阈值，开始回收垃圾
 	if(gc_queue.size() > gc_threshold) {
 		gc();
@@ -373,6 +891,58 @@ void rco::Processor::state_finish() {
 
 
 
+void rco::Processor::cancel_all() {
+	// 取出所有未完成的协程(执行器线程已退出调度)
+	TSList<Task> list = ready_queue.pop_all();
+	{
+		std::unique_lock<TaskQueue_ts::lock_t> scope_lock(runnable_queue.lock_ref());
+		list.append(runnable_queue.nolock_pop_all());
+		list.append(wait_queue.nolock_pop_all());
+		running_task = nullptr;
+		next_task = nullptr;
+	}
+
+	// 与gc相同，释放协程自身的引用，清理时释放队列的引用
+	// 被取消的协程同样计为完成，关闭过程的未完成协程数归零
+	for(Task& task : list) {
+		task.check = nullptr;
+		task.decrement_ref();
+		own_scheduler->task_finished();
+	}
+	list.clear();
+
+	gc();
+}
+
+void rco::Processor::retire() {
+	std::unique_lock<TaskQueue_ts::lock_t> scope_lock(ready_queue.lock_ref());
+
+	active = false;
+	retiring = true;
+
+	// 唤醒执行器，使其退出调度
+	if(wait_flag) {
+		cv.notify_all();
+	} else {
+		notified = true;
+	}
+}
+
+uint64_t rco::Processor::idle_time() {
+	if(!wait_flag) {
+		return 0;
+	}
+	uint64_t now = own_scheduler->tick;
+	uint64_t since = idle_since;
+	return now > since ? now - since : 0;
+}
+
 void rco::Processor::make_tag() {
+	uint64_t count = switch_count;
 
+	// 协程发生了切换，说明执行器没有阻塞，更新标记
+	if(tag_switch != count) {
+		tag_switch = count;
+		tag_tick = own_scheduler->tick;
+	}
 }	
@@ -2,11 +2,19 @@
 
 #include "../task/task.h"
 
+#include "introspect.h"
+#include "metrics.h"
+#include "trace.h"
 #include "runtime.h"
 
 #include <atomic>
+#include <csignal>
 #include <cstdint>
 #include <condition_variable>
+#include <functional>
+#include <thread>
+
+#include <pthread.h>
 
 namespace rco {
 	class Runtime;
@@ -34,9 +42,11 @@ namespace rco {
 		/**
 		 * @brief 获取当前工作中的执行器
 		 *
+		 * 协程切出后可能在其他线程上恢复，不内联以免线程局部变量的地址被缓存
+		 *
 		 * @return 执行器
 		 */
-		RCO_STATIC Processor* & CurrentProcessor();
+		RCO_STATIC RCO_NOINLINE Processor* & CurrentProcessor();
 
 		/**
 		 * @brief 获取当前工作中的执行器所属的调度器
@@ -72,8 +82,20 @@ namespace rco {
 			return wait_flag;
 		}
 
+		/**
+		 * @brief 执行器是否阻塞(当前协程运行时间超过阈值仍未切出)
+		 *
+		 * @return 是 ? true : false
+		 */
 		bool blocking();
 
+		/**
+		 * @brief 获取当前协程已运行的时间(以分发线程的调度时刻计算，精度为一个调度周期)
+		 *
+		 * @return 微秒，没有运行中的协程时为0
+		 */
+		uint64_t running_time();
+
 		/**
 		 * @brief 切出当前协程
 		 *
@@ -81,6 +103,52 @@ namespace rco {
 		 */
 		RCO_STATIC void CoYield();
 
+		/**
+		 * @brief 挂起当前协程，直到被CoWake唤醒
+		 *
+		 * @param[in] on_parked 协程切出并放入等待队列后，由执行器调用的回调
+		 *					  (在回调中发起的唤醒一定发生在挂起之后)
+		 * @param[in] reason	挂起原因(静态字符串)，在协程快照中显示
+		 */
+		RCO_STATIC void CoPark(const std::function<void()>& on_parked, const char* reason = "park");
+
+		/**
+		 * @brief 唤醒挂起的协程，可在任意线程调用
+		 *
+		 * @param[in] task 被CoPark挂起的协程
+		 */
+		RCO_STATIC void CoWake(Task* task);
+
+		/**
+		 * @brief 抢占安全点：当前协程已被请求抢占(运行超过时间片)时切出
+		 */
+		RCO_STATIC void CoPreemptPoint();
+
+		/**
+		 * @brief 安装抢占信号处理函数(只安装一次)
+		 */
+		RCO_STATIC void InstallPreemptHandler();
+
+		/**
+		 * @brief 安装栈访问异常(SIGSEGV)处理函数(只安装一次)，协程使用 eGuard/eGrowable 栈时需要
+		 */
+		RCO_STATIC void InstallFaultHandler();
+
+		/**
+		 * @brief 获取执行器指标快照
+		 *
+		 * @param[out] out 快照
+		 */
+		void stats(Proc_stats& out);
+
+		/**
+		 * @brief 获取执行器上所有协程的快照(运行中、可执行、就绪、挂起)
+		 *
+		 * @param[out] out 快照追加到末尾
+		 * @param[in]  max_frames 每个协程最多回溯的调用栈层数
+		 */
+		void tasks(std::vector<Task_info>& out, size_t max_frames);
+
 		private:
 
 		/**
@@ -92,30 +160,104 @@ namespace rco {
 		explicit Processor(Scheduler* scheduler, int id);
 
 		/**
-		 * @brief 获取待执行协程数
+		 * @brief 获取待执行协程数(包括正在运行的协程)，不加锁，可能读到旧值
 		 *
 		 * @return 待执行协程数
 		 */
-		size_t runnable_count();
+		RCO_INLINE size_t runnable_count() const {
+			// 可运行协程队列大小 + 就绪协程队列大小
+			// 当可运行协程队列中协程不够时，将会把就绪队列中的协程取出
+			// 因此可运行协程数 为 两个队列长度之和
+			return runnable_queue.approx_size() + ready_queue.approx_size();
+		}
+
+		/**
+		 * @brief 更新负载的指数移动平均，由分发线程每个调度周期调用一次
+		 *
+		 * @param[in] depth 本周期采样的待执行协程数
+		 */
+		void update_load(size_t depth);
+
+		/**
+		 * @brief 待执行协程数的指数移动平均
+		 *
+		 * @return 定点数，低 kLoadShift 位为小数
+		 */
+		RCO_INLINE uint32_t load_average() const {
+			return load_avg.load(std::memory_order_relaxed);
+		}
+
+		/**
+		 * @brief 忙碌(不在等待协程)比例的指数移动平均
+		 *
+		 * @return 定点数，1 << kLoadShift 表示一直忙碌
+		 */
+		RCO_INLINE uint32_t busy_average() const {
+			return busy_avg.load(std::memory_order_relaxed);
+		}
+
+		RCO_STATIC RCO_CONSTEXPR uint32_t kLoadShift = 8;
 
 		/**
 		 * @brief 协程切出(让出执行权)
 		 */
 		void coyield();
 
+		/**
+		 * @brief 切出协程：下一个可执行的协程可以被直接切入时直接切换，否则回到调度上下文
+		 *
+		 * @param[in] task 当前协程(状态为eRunnable或eWait)
+		 */
+		void switch_out(Task* task);
+
+		/**
+		 * @brief 协程切出：记录本次运行的时间与切出的调度时刻
+		 *
+		 * @param[in] task 切出的协程
+		 */
+		void finish_run(Task* task);
+
+		/**
+		 * @brief 切入协程前更新协程状态与切换计数
+		 *
+		 * @param[in] task 即将运行的协程
+		 */
+		void prepare_resume(Task* task);
+
+		/**
+		 * @brief 释放直接切换时持有的可执行队列锁
+		 */
+		void unlock_switch();
+
+		/**
+		 * @brief 协程切入后执行：释放切换时持有的锁，执行上一个协程的挂起回调
+		 *
+		 * 协程可能已经迁移到其他执行器上，因此重新获取当前执行器
+		 */
+		RCO_STATIC RCO_NOINLINE void AfterSwitch();
+
+		/**
+		 * @brief 执行挂起回调(协程切出后执行)
+		 */
+		void run_park_hook();
+
 		/**
 		 * @brief 添加协程
 		 *
 		 * @param[in] task 任务对象(对应于协程)
+		 *
+		 * @return 执行器已被回收 ? false : true
 		 */
-		void add_task(Task* task);
+		bool add_task(Task* task);
 
 		/**
 		 * @brief 批量添加协程
 		 *
-		 * @param[in] list 协程列表
+		 * @param[in] list 协程列表(一次加锁放入)
+		 *
+		 * @return 执行器已被回收 ? false(列表保持不变) : true
 		 */
-		void add_task(TSList<Task> && list);
+		bool add_task(TSList<Task> && list);
 
 		/**
 		 * @brief 开始调度
@@ -132,8 +274,54 @@ namespace rco {
 
 		void wait_notify();
 
+		/**
+		 * @brief 打标记，记录协程切换次数及对应的调度时刻，用于检测执行器阻塞
+		 */
 		void make_tag();
 
+		/**
+		 * @brief 回收执行器：取消激活，执行完剩余协程后线程退出
+		 */
+		void retire();
+
+		/**
+		 * @brief 取消所有未完成的协程并释放(协程栈不会展开)，只能在执行器线程退出调度后调用
+		 */
+		void cancel_all();
+
+		/**
+		 * @brief 获取执行器的空闲时间
+		 *
+		 * @return 微秒，不处于等待状态时为0
+		 */
+		uint64_t idle_time();
+
+		/**
+		 * @brief 请求抢占当前协程：向执行器线程发送抢占信号(同一次切换只发送一次)
+		 */
+		void preempt();
+
+		/**
+		 * @brief 抢占信号处理函数
+		 *
+		 * 允许异步抢占的协程直接在信号处理函数中切出，其余协程设置抢占标志，在安全点切出
+		 */
+		RCO_STATIC void OnPreemptSignal(int sig);
+
+		/**
+		 * @brief 栈访问异常处理函数，运行在执行器线程的信号栈上
+		 *
+		 * 访问 eGrowable 栈未提交的区域时扩展栈；访问保护页时输出协程id，交给之前的处理方式(默认生成core)
+		 */
+		RCO_STATIC void OnFaultSignal(int sig, siginfo_t* info, void* uctx);
+
+		/**
+		 * @brief 将挂起的协程移出等待队列并重新加入调度
+		 *
+		 * @param[in] task 协程对象
+		 */
+		void wake(Task* task);
+
 		void gc();
 
 		TSList<Task> steal(std::size_t n);
@@ -153,6 +341,11 @@ namespace rco {
 		Task*			running_task;	// 正在运行的协程
 		Task*			next_task;		// 下一个要运行的协程
 
+		RContext		sched_ctx;		// 调度上下文(运行在执行器线程自身的栈上)
+		bool			switch_locked;	// 直接切换时持有可执行队列锁
+
+		core::Stack_cache stack_cache;	// 已结束协程归还的栈
+
 		TaskQueue_ts	runnable_queue; // 可运行的协程队列
 		TaskQueue_ts	wait_queue;		// 阻塞的协程队列
 		TaskQueue_ts	ready_queue;	// 就绪的协程队列
@@ -164,14 +357,33 @@ namespace rco {
 
 		bool			notified;		// 唤醒标志
 		volatile bool	active;
+		volatile bool	blocked;		// 阻塞标志(由分发线程检测)
+		volatile bool	retiring;		// 回收标志(由分发线程设置)
+		volatile bool	retired;		// 已回收，线程已退出调度(调度器停止时同样设置)
+
+		volatile uint64_t idle_since;	// 开始等待的调度时刻(微秒)
+
+		std::thread		thread;			// 执行器线程(主执行器运行在调用start的线程上，为空)
 
 		size_t			gc_threshold;
 
 		int				quota;
 
-		volatile uint64_t tag_tick;
-		volatile uint64_t tag_switch;
+		volatile uint64_t tag_tick;		// 观察到协程切换时的调度时刻(微秒)
+		volatile uint64_t tag_switch;	// 打标记时的协程切换次数
+
+		volatile uint64_t switch_count; // 协程切换次数
+
+		std::atomic<uint32_t> load_avg;	// 待执行协程数的指数移动平均(只由分发线程写入)
+		std::atomic<uint32_t> busy_avg;	// 忙碌比例的指数移动平均(只由分发线程写入)
+
+		Proc_metrics	metrics;		// 执行器指标
+		uint64_t		run_since;		// 当前协程切入的时刻(纳秒，开启耗时统计时记录)
+
+		std::function<void()> park_hook; // 协程挂起后执行的回调
 
-		volatile uint64_t switch_count;
+		pthread_t		native_thread;	// 执行器所在的线程
+		volatile uint64_t preempt_switch;	 // 发送抢占信号时的协程切换次数
+		volatile sig_atomic_t preempt_flag; // 抢占标志，在安全点检查
 	};
 }
@@ -5,12 +5,34 @@
 #include "processor.h"
 #include "scheduler.h"
 
+// Runtime中的设置同时作为新建调度器(Scheduler::Make)的默认配置，
+// 修改和读取的是当前调度器的配置，不在协程中时为默认调度器(Scheduler::Instance)
+
 rco::Runtime::Env rco::Runtime::env;
 
+/**
+ * @brief 获取当前调度器
+ *
+ * @return 当前执行器所属的调度器，不在执行器线程中时为默认调度器
+ */
+RCO_STATIC rco::Scheduler& Current_scheduler() {
+	rco::Scheduler* sched = rco::Processor::CurrentScheduler();
+	return sched ? *sched : rco::Scheduler::Instance();
+}
+
 rco::Runtime::Env::Env()
 	: proc_count(std::thread::hardware_concurrency())
 	  ,gc_threshold(16)
-	  , load_balance_rate(0.01) {
+	  , load_balance_rate(0.01)
+	  , blocking_thread_count(64)
+	  , block_threshold(10000)
+	  , time_slice(0)
+	  , scale_depth(128)
+	  , scale_latency(5000)
+	  , idle_timeout(1000000)
+	  , stack_mode(core::Stack_mode::eHeap)
+	  , max_stack_size(1024 << 10)
+	  , placement(rco::Placement::eLocal) {
 
 	  }
 
@@ -32,26 +54,166 @@ uint16_t rco::Runtime::CPU_count() {
 }
 
 void rco::Runtime::GC() {
-	Processor::CurrentScheduler()->GC();
+	Current_scheduler().GC();
 }
 
-void rco::Runtime::Set_GC_threshold(std::size_t val) {
+void rco::Runtime::Set_GC_threshold(uint16_t val) {
 	env.gc_threshold = val;
-	if(!Processor::CurrentScheduler()) return;
-	Processor::CurrentScheduler()->update_threshold(env.gc_threshold);
+	Scheduler& sched = Current_scheduler();
+	sched.config.gc_threshold = val;
+	sched.update_threshold(val);
 }
 
 uint16_t rco::Runtime::GC_threshold() {
-	return env.gc_threshold;
+	return Current_scheduler().config.gc_threshold;
 }
 
 
 void rco::Runtime::Set_load_balance(std::size_t rate) {
 	if(rate) {
 		env.load_balance_rate = rate;
+		Current_scheduler().config.load_balance_rate = rate;
 	}
 }
 
 float rco::Runtime::Load_balance_rate() {
-	return env.load_balance_rate;
+	return Current_scheduler().config.load_balance_rate;
+}
+
+void rco::Runtime::Set_max_blocking_threads(uint16_t n) {
+	if(!n) return;
+	env.blocking_thread_count = n;
+	Scheduler& sched = Current_scheduler();
+	sched.config.max_blocking_threads = n;
+	sched.blocking_pool.set_max_threads(n);
+}
+
+uint16_t rco::Runtime::Max_blocking_threads() {
+	return Current_scheduler().config.max_blocking_threads;
+}
+
+void rco::Runtime::Set_block_threshold(uint32_t us) {
+	if(us) {
+		env.block_threshold = us;
+		Current_scheduler().config.block_threshold = us;
+	}
+}
+
+uint32_t rco::Runtime::Block_threshold() {
+	return Current_scheduler().config.block_threshold;
+}
+
+void rco::Runtime::Set_time_slice(uint32_t us) {
+	// 0 表示关闭抢占
+	if(us) {
+		Processor::InstallPreemptHandler();
+	}
+	env.time_slice = us;
+	Current_scheduler().config.time_slice = us;
+}
+
+uint32_t rco::Runtime::Time_slice() {
+	return Current_scheduler().config.time_slice;
+}
+
+void rco::Runtime::Preempt_point() {
+	Processor::CoPreemptPoint();
+}
+
+void rco::Runtime::Set_scale_depth(uint32_t n) {
+	if(n) {
+		env.scale_depth = n;
+		Current_scheduler().config.scale_depth = n;
+	}
+}
+
+uint32_t rco::Runtime::Scale_depth() {
+	return Current_scheduler().config.scale_depth;
+}
+
+void rco::Runtime::Set_scale_latency(uint32_t us) {
+	if(us) {
+		env.scale_latency = us;
+		Current_scheduler().config.scale_latency = us;
+	}
+}
+
+uint32_t rco::Runtime::Scale_latency() {
+	return Current_scheduler().config.scale_latency;
+}
+
+void rco::Runtime::Set_idle_timeout(uint32_t us) {
+	if(us) {
+		env.idle_timeout = us;
+		Current_scheduler().config.idle_timeout = us;
+	}
+}
+
+uint32_t rco::Runtime::Idle_timeout() {
+	return Current_scheduler().config.idle_timeout;
+}
+
+void rco::Runtime::Set_stack_mode(core::Stack_mode mode) {
+	env.stack_mode = mode;
+	Current_scheduler().config.stack_mode = mode;
+}
+
+rco::core::Stack_mode rco::Runtime::Stack_mode() {
+	return Current_scheduler().config.stack_mode;
+}
+
+void rco::Runtime::Set_max_stack_size(std::size_t size) {
+	if(size) {
+		env.max_stack_size = size;
+		Current_scheduler().config.max_stack_size = size;
+	}
+}
+
+std::size_t rco::Runtime::Max_stack_size() {
+	return Current_scheduler().config.max_stack_size;
+}
+
+void rco::Runtime::Set_placement(rco::Placement placement) {
+	env.placement = placement;
+	Current_scheduler().config.placement = placement;
+}
+
+rco::Placement rco::Runtime::Placement_policy() {
+	return Current_scheduler().config.placement;
+}
+
+rco::Sched_stats rco::Runtime::Stats() {
+	return Current_scheduler().stats();
+}
+
+void rco::Runtime::Set_metrics_timing(bool on) {
+	Metrics::Enable_timing(on);
+}
+
+std::vector<rco::Task_info> rco::Runtime::Tasks() {
+	return Current_scheduler().tasks();
+}
+
+void rco::Runtime::Dump_tasks(std::ostream& os) {
+	Current_scheduler().dump_tasks(os);
+}
+
+void rco::Runtime::Install_dump_signal(int sig) {
+	Scheduler::InstallDumpSignal(sig);
+}
+
+rco::Sched_config rco::Runtime::Default_config() {
+	Sched_config config;
+	config.gc_threshold = env.gc_threshold;
+	config.load_balance_rate = env.load_balance_rate;
+	config.max_blocking_threads = env.blocking_thread_count;
+	config.block_threshold = env.block_threshold;
+	config.time_slice = env.time_slice;
+	config.scale_depth = env.scale_depth;
+	config.scale_latency = env.scale_latency;
+	config.idle_timeout = env.idle_timeout;
+	config.stack_mode = env.stack_mode;
+	config.max_stack_size = env.max_stack_size;
+	config.placement = env.placement;
+	return config;
 }
@@ -3,12 +3,25 @@
 #include <cstdint>
 #include <atomic>
 
+#include "config.h"
+#include "introspect.h"
+#include "metrics.h"
+
 namespace rco {
 	class Runtime {
 		struct Env {
 			std::atomic<uint16_t> proc_count;
 			std::atomic<uint16_t> gc_threshold;
 			std::atomic<float>	  load_balance_rate;
+			std::atomic<uint16_t> blocking_thread_count;
+			std::atomic<uint32_t> block_threshold;
+			std::atomic<uint32_t> time_slice;
+			std::atomic<uint32_t> scale_depth;
+			std::atomic<uint32_t> scale_latency;
+			std::atomic<uint32_t> idle_timeout;
+			std::atomic<core::Stack_mode> stack_mode;
+			std::atomic<std::size_t> max_stack_size;
+			std::atomic<Placement> placement;
 			Env();
 		};
 		public:
@@ -20,10 +33,35 @@ namespace rco {
 		static void Set_max_procs(uint16_t n);
 		static uint16_t CPU_count();
 		static void GC();
-		static void Set_GC_threshold(std::size_t val);
+		static void Set_GC_threshold(uint16_t val);
 		static uint16_t GC_threshold();
 		static void Set_load_balance(std::size_t rate);
 		static float Load_balance_rate();
+		static void Set_max_blocking_threads(uint16_t n);
+		static uint16_t Max_blocking_threads();
+		static void Set_block_threshold(uint32_t us);
+		static uint32_t Block_threshold();
+		static void Set_time_slice(uint32_t us);
+		static uint32_t Time_slice();
+		static void Preempt_point();
+		static void Set_scale_depth(uint32_t n);
+		static uint32_t Scale_depth();
+		static void Set_scale_latency(uint32_t us);
+		static uint32_t Scale_latency();
+		static void Set_idle_timeout(uint32_t us);
+		static uint32_t Idle_timeout();
+		static void Set_stack_mode(core::Stack_mode mode);
+		static core::Stack_mode Stack_mode();
+		static void Set_max_stack_size(std::size_t size);
+		static std::size_t Max_stack_size();
+		static void Set_placement(Placement placement);
+		static Placement Placement_policy();
+		static Sched_config Default_config();
+		static Sched_stats Stats();
+		static void Set_metrics_timing(bool on);
+		static std::vector<Task_info> Tasks();
+		static void Dump_tasks(std::ostream& os);
+		static void Install_dump_signal(int sig);
 		private:
 		static Env env;
 	};
@@ -1,11 +1,17 @@
 #include "scheduler.h"
+#include "../task/stack_profile.h"
 
 #include <iostream>
 
+#include <algorithm>
 #include <atomic>
 #include <cstdlib>
+#include <cstring>
 #include <functional>
+#include <memory>
 #include <mutex>
+#include <pthread.h>
+#include <sched.h>
 #include <stdexcept>
 #include <thread>
 #include <vector>
@@ -43,25 +49,41 @@ struct Exit_Op {
 	}
 };
 
-struct ID_Generator {
-
-	RCO_STATIC ID_Generator& Instance() {
-		RCO_STATIC ID_Generator generator;
-		return generator;
-	}
+/**
+ * @brief 获取单调时钟的当前时刻
+ *
+ * @return 微秒
+ */
+RCO_STATIC RCO_INLINE uint64_t Now_us() {
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+}
 
-	RCO_INLINE uint64_t make() {
-		return ++id;
-	}
+// 调度器id生成
+RCO_STATIC std::atomic<uint16_t> s_sched_seed(0);
 
-	ID_Generator()
-		: id(0) {
+// 协程快照请求(由快照信号累加)
+RCO_STATIC volatile sig_atomic_t s_dump_request = 0;
 
-		}
+RCO_STATIC void OnDumpSignal(int) {
+	s_dump_request = s_dump_request + 1;
+}
 
-	private:
-	std::atomic<uint64_t> id;
-};
+/**
+ * @brief 线程局部的伪随机数(xorshift)，用于随机选择执行器
+ *
+ * @return 随机数
+ */
+RCO_STATIC uint32_t Fast_random() {
+	RCO_STATIC thread_local uint32_t s_state = 0;
+	if(!s_state) {
+		s_state = ((uint32_t)(uintptr_t)&s_state ^ (uint32_t)Now_us()) | 1;
+	}
+	s_state ^= s_state << 13;
+	s_state ^= s_state >> 17;
+	s_state ^= s_state << 5;
+	return s_state;
+}
 
 void rco::Scheduler::OnExit() {
 	atexit(&OnExitDoWork);
@@ -72,11 +94,31 @@ void rco::Scheduler::OnExitDoWork() {
 }
 
 rco::Scheduler::Scheduler()
+	: Scheduler(Runtime::Default_config()) {
+
+	}
+
+rco::Scheduler::Scheduler(const Sched_config& conf)
 	: running(true)
+      , proc_count(1)
+      , task_count(0)
+      , unfinished(0)
+      , accepting(true)
+      , launched(false)
+      , finished(false)
+      , released(false)
+      , tick(Now_us())
+      , sched_id(++s_sched_seed)
+      , dump_seen(s_dump_request)
+      , task_seed(0)
+      , config(conf)
+      , blocking_pool(conf.max_blocking_threads)
 	  , min_thread_count(1)
 	  , max_thread_count(1)
-      , task_count(0)
-      , last_active(0){
+      , peak_thread_count(1)
+      , grow_count(0)
+      , shrink_count(0)
+      , last_resize(0) {
 		  // 初始执行器
 		  processors.push_back(new Processor(this, 0));
 	  }
@@ -91,30 +133,148 @@ rco::Scheduler& rco::Scheduler::Instance() {
 }
 
 rco::Scheduler* rco::Scheduler::Make() {
-	Scheduler* sched = new Scheduler;
+	return Make(Runtime::Default_config());
+}
+
+rco::Scheduler* rco::Scheduler::Make(const Sched_config& config) {
+	// 进程退出时执行资源回收回调(只注册一次)，回调表先于退出函数构造，析构在其之后
+	RCO_STATIC bool s_on_exit = (Exit_Op::Instance(), OnExit(), true);
+	(void)s_on_exit;
+
+	Scheduler* sched = new Scheduler(config);
 	std::unique_lock<std::mutex> scope_lock(Exit_Op::Instance().ex_mtx);
-	// 注册资源回收回调
+	// 注册资源回收回调：只回收已关闭且执行器已释放的调度器，
+	// 未关闭或仍有阻塞线程的调度器可能还在被使用
 	Exit_Op::Instance().register_cb(
 			std::move([=]{
-				delete sched;
+				if(sched->released) {
+					delete sched;
+				}
 				})
 			);
 
 	return sched;
 }
 
-void rco::Scheduler::make_task(const Task::Execute& execute, const Task::Attribute& attr) {
-	
+bool rco::Scheduler::make_task(const Task::Execute& execute, const Task::Attribute& attr) {
+	if(!reserve_task()) {
+		return false;
+	}
+	// 调度器已经停止时被丢弃，与执行完毕的协程一样释放预留
+	add_task(new_task(execute, task_attribute(attr, __builtin_return_address(0))));
+	return true;
+}
+
+bool rco::Scheduler::reserve_task(uint32_t n) {
+	// 先计入未完成的协程数再检查是否接受：关闭过程先置 accepting=false 再等待 unfinished 归零，
+	// 两者至少有一方看到对方的修改，通过检查的协程一定会被排空等待
+	unfinished += n;
+	// 正在关闭，只接受本调度器中的协程创建的协程(完成排空)
+	if(!accepting && (!running.load(std::memory_order_acquire) || Processor::CurrentScheduler() != this)) {
+		task_finished(n);
+		return false;
+	}
+	return true;
+}
+
+void rco::Scheduler::make_reserved_task(const Task::Execute& execute, const Task::Attribute& attr) {
+	add_task(new_task(execute, task_attribute(attr, __builtin_return_address(0))));
+}
+
+rco::Task::Attribute rco::Scheduler::task_attribute(const Task::Attribute& attr, void* spawn_site) {
+	// 使用带保护页的栈时需要处理栈访问异常
+	if(attr.stack_mode != core::Stack_mode::eHeap) {
+		Processor::InstallFaultHandler();
+	}
+
+	Task::Attribute task_attr = attr;
+	task_attr.profile_stack = Stack_profile::Enabled();
+	// 未指定创建位置时，取调用者的地址
+	if(!task_attr.spawn_site) {
+		task_attr.spawn_site = spawn_site;
+	}
+	return task_attr;
+}
+
+bool rco::Scheduler::make_tasks(std::size_t count, const Batch_execute& execute, const Task::Attribute& attr) {
+	if(!count) {
+		return true;
+	}
+	if(!reserve_task(static_cast<uint32_t>(count))) {
+		return false;
+	}
+	Task::Attribute task_attr = task_attribute(attr, __builtin_return_address(0));
+
+	// 各协程共享同一份执行实体，不逐个复制其捕获的状态
+	std::shared_ptr<const Batch_execute> shared(new Batch_execute(execute));
+
+	// 按激活的执行器平分，从放置策略选择的执行器开始轮转
+	std::size_t proc_count = processor_count();
+	std::size_t active_count = 0;
+	for(std::size_t i = 0; i < proc_count; ++i) {
+		if(processors[i]->active) {
+			++active_count;
+		}
+	}
+	if(!active_count) {
+		active_count = 1;
+	}
+	std::size_t per_proc = (count + active_count - 1) / active_count;
+
+	Processor* proc = place_task();
+	std::size_t index = 0;
+	while(index < count) {
+		TSList<Task> tasks;
+		std::size_t end = std::min(count, index + per_proc);
+		for(; index < end; ++index) {
+			Task* task = new_task([shared, index]{ (*shared)(index); }, task_attr);
+			// 与逐个放入一致，就绪队列持有一个引用
+			task->increment_ref();
+			tasks.append(TSList<Task>(task, task, 1));
+		}
+		// 每批创建完即放入，先放入的协程可以在创建其余协程时开始运行
+		add_tasks(proc, std::move(tasks));
+
+		proc = active_processor(proc->id() + 1, proc_count);
+		if(!proc) {
+			proc = processors[0];
+		}
+	}
+	return true;
+}
+
+rco::Task* rco::Scheduler::new_task(const Task::Execute& execute, const Task::Attribute& attr) {
 	Task* task = new Task(execute, attr);
 	// 注册资源回收回调
 	task->set_destructor(Destructor(&Scheduler::DelTask, this));
-	// 生成协程id
-	uint64_t id = ID_Generator::Instance().make();
+	// 生成协程id(高16位为调度器id，保证进程内唯一)
+	uint64_t id = (static_cast<uint64_t>(sched_id) << 48) | ++task_seed;
 	task->set_id(id);
+	task->set_last_run(tick);
 
+	// 未完成的协程数已在检查是否接受之前计入
 	++task_count;
 
-	add_task(task);
+	// 在协程中创建时计入当前执行器
+	Processor* current = Processor::CurrentProcessor();
+	if(current) {
+		Proc_metrics::Add(current->metrics.spawned);
+	}
+	RCO_TRACE_EVENT(eSpawn, id, current ? current->id() : 0, 0);
+	return task;
+}
+
+void rco::Scheduler::drop_task(Task* task) {
+	task->decrement_ref();
+	task_finished();
+}
+
+void rco::Scheduler::task_finished(uint32_t n) {
+	// 最后一个协程执行完毕，通知正在等待排空的关闭过程
+	if(unfinished.fetch_sub(n) == n && !accepting) {
+		std::unique_lock<std::mutex> scope_lock(drain_mutex);
+		drain_cv.notify_all();
+	}
 }
 
 bool rco::Scheduler::working() {
@@ -125,7 +285,7 @@ bool rco::Scheduler::empty() {
 	return (task_count == 0);
 }
 
-void rco::Scheduler::start(uint16_t min_thread_cnt, uint16_t max_thread_cnt) {
+void rco::Scheduler::start(uint16_t min_thread_cnt, uint16_t max_thread_cnt, bool background) {
 	if(!started.try_lock())	{
 		throw std::logic_error("repeated call start func.");
 	}
@@ -141,6 +301,16 @@ void rco::Scheduler::start(uint16_t min_thread_cnt, uint16_t max_thread_cnt) {
 	min_thread_count = min_thread_cnt;
 	max_thread_count = max_thread_cnt;
 
+	// 预留执行器表，之后添加执行器不会重新分配内存(其他线程无锁读取)
+	processors.reserve(max_thread_count);
+	// 分发线程的负载快照同样预留，每个调度周期不分配内存
+	active_loads.reserve(max_thread_count);
+	blocking_loads.reserve(max_thread_count);
+
+	if(config.time_slice) {
+		Processor::InstallPreemptHandler();
+	}
+
 	// 主执行器
 	Processor* main_proc = processors[0];
 
@@ -149,33 +319,64 @@ void rco::Scheduler::start(uint16_t min_thread_cnt, uint16_t max_thread_cnt) {
 		make_processor_thread();
 	}
 
-	// 如果最大线程数大于1
-	if(max_thread_count > 1) {
-		// 开启调度线程(也可叫分发线程，用来委派任务)
-		std::thread th([this]{
-				this->do_dispatch();
+	launched = true;
+
+	// 开启调度线程(也可叫分发线程，用来委派任务、检测阻塞和抢占)
+	std::thread th([this]{
+			this->do_dispatch();
+			});
+	dispatch_thread.swap(th);
+
+	// 后台模式，主执行器运行在新线程上
+	if(background) {
+		std::thread main_th([main_proc]{
+				main_proc->scheduling();
 				});
-		dispatch_thread.swap(th);
-	} else {
-//		throw std::runtime_error("no dispatch thread");
+		bind_cpus(main_th);
+		main_proc->thread.swap(main_th);
+		return;
 	}
+
 	// 主执行器开始调度
 	main_proc->scheduling();
+
+	// 调度器正在关闭，等待关闭完成后返回
+	std::unique_lock<std::mutex> scope_lock(drain_mutex);
+	drain_cv.wait(scope_lock, [this]{
+			return accepting || finished;
+			});
+}
+
+void rco::Scheduler::bind_cpus(std::thread& th) {
+	if(config.cpus.empty()) {
+		return;
+	}
+
+#if defined(RCO_PLATFORM_LINUX)
+	cpu_set_t cpu_set;
+	CPU_ZERO(&cpu_set);
+	for(int cpu : config.cpus) {
+		CPU_SET(cpu, &cpu_set);
+	}
+	pthread_setaffinity_np(th.native_handle(), sizeof(cpu_set), &cpu_set);
+#endif
 }
 
 void rco::Scheduler::stop() {
 	std::unique_lock<std::mutex> scope_lock(mutex);
 
 	// 如果已经停止 直接返回
-	if(!running) return;
+	if(!running.load(std::memory_order_acquire)) return;
 
 	// 更新运行状态
-	running = false;
+	running.store(false, std::memory_order_release);
 
-	// 唤醒所有执行器，执行任务
-	for(Processor* p : processors) {
+	// 唤醒所有执行器，退出调度
+	std::size_t count = processor_count();
+	for(std::size_t i = 0; i < count; ++i) {
+		Processor* p = processors[i];
 		if(p) {
-			p->wait_notify();
+			p->notify();
 		}
 	}
 
@@ -190,6 +391,127 @@ void rco::Scheduler::stop() {
 //	}
 }
 
+bool rco::Scheduler::shutdown(std::chrono::milliseconds timeout) {
+	auto deadline = std::chrono::steady_clock::now() + timeout;
+
+	// 在本调度器的执行器线程中调用，无法等待自身退出，在新线程中关闭
+	if(Processor::CurrentScheduler() == this && Processor::CurrentProcessor()) {
+		std::thread([this, timeout]{
+				this->shutdown(timeout);
+				}).detach();
+		return false;
+	}
+
+	bool drained = true;
+	{
+		std::unique_lock<std::mutex> scope_lock(drain_mutex);
+		// 已经关闭
+		if(!accepting) {
+			return false;
+		}
+		// 不再接受外部创建的协程
+		accepting = false;
+
+		// 等待所有协程执行完毕(未开始调度时直接取消)
+		if(launched) {
+			drained = drain_cv.wait_until(scope_lock, deadline, [this]{
+					return unfinished == 0;
+					});
+		} else {
+			drained = (unfinished == 0);
+		}
+	}
+
+	// 停止调度，唤醒所有执行器并等待分发线程退出
+	stop();
+
+	// 等待执行器退出调度，正在运行的协程需要切出后执行器才能退出，给予一定的宽限时间
+	bool joined = join_processors(std::max(deadline, std::chrono::steady_clock::now())
+			+ std::chrono::milliseconds(100));
+
+	// 取消剩余的协程并回收(阻塞的执行器未退出，其中的协程不回收)
+	std::size_t count = processor_count();
+	for(std::size_t i = 0; i < count; ++i) {
+		Processor* p = processors[i];
+		if(p->retired) {
+			p->cancel_all();
+		}
+	}
+
+	// 阻塞调用线程池
+	bool pool_exited = blocking_pool.shutdown(std::max(deadline, std::chrono::steady_clock::now()));
+
+	// 所有线程都已退出，释放执行器及其缓存的协程栈(有线程未退出时保留，它们仍可能访问执行器)
+	if(joined && pool_exited) {
+		release_processors();
+	}
+
+	{
+		std::unique_lock<std::mutex> scope_lock(drain_mutex);
+		finished = true;
+		drain_cv.notify_all();
+	}
+
+	return drained && joined && pool_exited;
+}
+
+bool rco::Scheduler::join_processors(std::chrono::steady_clock::time_point deadline) {
+	std::size_t count = processor_count();
+	bool all_exited = false;
+
+	while(true) {
+		all_exited = true;
+		for(std::size_t i = 0; i < count; ++i) {
+			Processor* p = processors[i];
+			if(!p->retired) {
+				all_exited = false;
+				// 执行器可能在唤醒后又进入等待
+				p->notify();
+			}
+		}
+
+		if(all_exited || std::chrono::steady_clock::now() >= deadline) {
+			break;
+		}
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	for(std::size_t i = 0; i < count; ++i) {
+		Processor* p = processors[i];
+		if(!p->thread.joinable()) {
+			continue;
+		}
+
+		if(p->retired) {
+			p->thread.join();
+		} else {
+			// 执行器阻塞在协程中，无法等待其退出
+			p->thread.detach();
+		}
+	}
+
+	return all_exited;
+}
+
+void rco::Scheduler::release_processors() {
+	std::size_t count = processor_count();
+	// 之后遍历执行器的接口(stats、tasks 等)看到的执行器个数为 0
+	proc_count.store(0, std::memory_order_release);
+
+	for(std::size_t i = 0; i < count; ++i) {
+		Processor* p = processors[i];
+		// 非后台模式的主执行器线程没有被 join，它在就绪队列锁内设置 retired，
+		// 加锁一次保证其已释放锁、不再访问执行器
+		{
+			std::unique_lock<Processor::TaskQueue_ts::lock_t> scope_lock(p->ready_queue.lock_ref());
+		}
+		delete p;
+	}
+	processors.clear();
+	released = true;
+}
+
 void rco::Scheduler::DelTask(rco::Ref_obj* task, void* arg) {
 	Scheduler* self = static_cast<Scheduler*>(arg);
 	delete task;
@@ -200,12 +522,197 @@ void rco::Scheduler::make_processor_thread() {
 	Processor* p = new Processor(this, processors.size());
 
 	// 开启调度线程
-	std::thread([this,p]{
+	std::thread th([p]{
 			p->scheduling();
-			}).detach();
+			});
+	bind_cpus(th);
+	p->thread.swap(th);
 
 	// 记录该执行器
 	processors.push_back(p);
+	proc_count.store(processors.size(), std::memory_order_release);
+
+	if(processors.size() > peak_thread_count) {
+		peak_thread_count = processors.size();
+	}
+}
+
+int rco::Scheduler::grow_processor() {
+	std::size_t count = processor_count();
+
+	// 优先恢复已回收的执行器
+	for(std::size_t i = 1; i < count; ++i) {
+		Processor* p = processors[i];
+		if(!p->retired) {
+			continue;
+		}
+
+		// 线程已退出调度
+		if(p->thread.joinable()) {
+			p->thread.join();
+		}
+
+		{
+			std::unique_lock<Processor::TaskQueue_ts::lock_t> scope_lock(p->ready_queue.lock_ref());
+			p->retiring = false;
+			p->retired = false;
+			p->blocked = false;
+			p->notified = false;
+			p->active = true;
+		}
+
+		std::thread th([p]{
+				p->scheduling();
+				});
+		bind_cpus(th);
+		p->thread.swap(th);
+
+		++grow_count;
+		last_resize = tick;
+		return i;
+	}
+
+	// 达到最大线程数
+	if(count >= max_thread_count) {
+		return -1;
+	}
+
+	make_processor_thread();
+
+	++grow_count;
+	last_resize = tick;
+	return count;
+}
+
+bool rco::Scheduler::need_grow(Load_table& active, std::size_t active_tasks) {
+	if(active.empty()) {
+		return false;
+	}
+
+	// 平均每个执行器的可执行协程数超过阈值，以移动平均判断，忽略单个周期的突发
+	uint64_t load_sum = 0;
+	for(const Proc_load& load : active) {
+		load_sum += load.avg;
+	}
+	if(active_tasks >= active.size() * config.scale_depth
+			&& (load_sum >> Processor::kLoadShift) >= active.size() * config.scale_depth) {
+		return true;
+	}
+
+	// 有协程排队的执行器，当前协程运行时间超过阈值(排队的协程等待过久)
+	// 可执行协程数包括正在运行的协程
+	uint32_t latency = config.scale_latency;
+	for(const Proc_load& load : active) {
+		if(load.depth > 1 && processors[load.pos]->running_time() >= latency) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void rco::Scheduler::shrink_processor(Load_table& active) {
+	uint32_t idle_timeout = config.idle_timeout;
+	std::size_t count = processor_count();
+
+	// 主执行器(0号)可能运行在调用start的线程上，不回收
+	for(std::size_t i = 1; i < count; ++i) {
+		Processor* p = processors[i];
+
+		if(p->retiring || p->blocked || p->idle_time() < idle_timeout) {
+			continue;
+		}
+
+		if(p->active) {
+			// 保留最少的执行器
+			if(active.size() <= min_thread_count) {
+				continue;
+			}
+
+			for(auto it = active.begin(); it != active.end(); ++it) {
+				if(it->pos == i) {
+					active.erase(it);
+					break;
+				}
+			}
+		}
+
+		// 未激活(如从阻塞中恢复)的空闲执行器直接回收
+		p->retire();
+
+		++shrink_count;
+		last_resize = tick;
+	}
+}
+
+rco::Sched_stats rco::Scheduler::stats() {
+	Sched_stats stats;
+	stats.sched_id = sched_id;
+	stats.tasks_alive = task_count;
+	stats.tasks_unfinished = unfinished;
+	stats.timing = Metrics::Timing();
+
+	std::size_t count = processor_count();
+	stats.processors.resize(count);
+	for(std::size_t i = 0; i < count; ++i) {
+		processors[i]->stats(stats.processors[i]);
+	}
+	return stats;
+}
+
+std::vector<rco::Task_info> rco::Scheduler::tasks(std::size_t max_frames) {
+	std::vector<Task_info> tasks;
+	std::size_t count = processor_count();
+	for(std::size_t i = 0; i < count; ++i) {
+		processors[i]->tasks(tasks, max_frames);
+	}
+	return tasks;
+}
+
+void rco::Scheduler::dump_tasks(std::ostream& os) {
+	os << "rco: scheduler " << sched_id << "\n";
+	Dump_tasks(os, tasks());
+}
+
+void rco::Scheduler::InstallDumpSignal(int sig) {
+	struct sigaction sa;
+	std::memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = &OnDumpSignal;
+	sa.sa_flags = SA_RESTART;
+	sigemptyset(&sa.sa_mask);
+	sigaction(sig, &sa, nullptr);
+}
+
+void rco::Scheduler::check_dump() {
+	sig_atomic_t request = s_dump_request;
+	if(request == dump_seen) {
+		return;
+	}
+	dump_seen = request;
+	dump_tasks(std::cerr);
+}
+
+rco::Scheduler::Resize_stats rco::Scheduler::resize_stats() {
+	Resize_stats stats;
+	std::size_t count = processor_count();
+
+	stats.threads = 0;
+	stats.active = 0;
+	for(std::size_t i = 0; i < count; ++i) {
+		Processor* p = processors[i];
+		if(!p->retired) {
+			++stats.threads;
+		}
+		if(p->active) {
+			++stats.active;
+		}
+	}
+
+	stats.peak = peak_thread_count;
+	stats.grow_count = grow_count;
+	stats.shrink_count = shrink_count;
+	stats.last_resize = last_resize;
+	return stats;
 }
 
 void rco::Scheduler::add_task(Task* task) {
@@ -213,84 +720,168 @@ void rco::Scheduler::add_task(Task* task) {
 
 	// 如果所属执行器有效(因此有可能是第一次创建的Task，不是旧的Task)
 	// 如果执行器有效且处于激活状态
-	if(proc && proc->active) {
+	if(proc && proc->active && proc->add_task(task)) {
 		// 直接将Task放入
-		proc->add_task(task);
 		return;
 	}
 
 	// 此时，proc可能无效，也可能是未激活的
-	// 获取当前运行的执行器
-	proc = Processor::CurrentProcessor();
-	// 如果执行器有效 并且处于激活态 并且属于当前调度器
-	if(proc && proc->active && (proc->belong_scheduler() == this) ) {
-		// 则 直接加入到当前proc中
-		proc->add_task(task);
-		return;
-	}
+	// 按放置策略选择执行器，执行器被回收时重新选择
+	while(true) {
+		// 调度器已经停止(执行器将退出调度)，丢弃该协程
+		if(!running.load(std::memory_order_acquire)) {
+			drop_task(task);
+			return;
+		}
 
-	std::size_t count = processors.size();
-	std::size_t last_actvive_index = last_active;
+		if(place_task()->add_task(task)) {
+			return;
+		}
+	}
+}
 
-	for(std::size_t i = 0; i < count; ++i, ++last_actvive_index) {
-		last_actvive_index = last_actvive_index % count;
-		proc = processors.at(last_actvive_index);
+void rco::Scheduler::add_tasks(Processor* proc, TSList<Task>&& tasks) {
+	while(!proc->add_task(std::move(tasks))) {
+		// 调度器已经停止，与逐个添加一致，丢弃这些协程
+		if(!running.load(std::memory_order_acquire)) {
+			for(auto it = tasks.begin(); it != tasks.end();) {
+				Task* task = &*it;
+				// 移出列表释放就绪队列的引用，再像逐个添加一样释放创建时的引用与预留
+				it = tasks.erase(it);
+				drop_task(task);
+			}
+			return;
+		}
+		proc = place_task();
+	}
+}
 
-		if(proc && proc->active) {
-			break;
+rco::Processor* rco::Scheduler::place_task() {
+	// 在本调度器的协程中创建时，放入当前执行器(与创建者共享缓存)
+	if(config.placement == Placement::eLocal) {
+		Processor* current = Processor::CurrentProcessor();
+		if(current && current->active && current->belong_scheduler() == this) {
+			return current;
 		}
 	}
 
-	proc->add_task(task);
+	std::size_t count = processor_count();
+	if(count == 1) {
+		return processors[0];
+	}
+
+	// 随机选取两个激活的执行器，放入可执行协程(不加锁读取)较少的一个，
+	// 不需要共享的轮转位置，突发的创建也能分散到各个执行器
+	Processor* first = active_processor(((uint64_t)Fast_random() * count) >> 32, count);
+	if(!first) {
+		return processors[0];
+	}
+	Processor* second = active_processor(((uint64_t)Fast_random() * count) >> 32, count);
+	if(!second) {
+		return first;
+	}
+
+	return second->runnable_count() < first->runnable_count() ? second : first;
+}
+
+rco::Processor* rco::Scheduler::active_processor(std::size_t pos, std::size_t count) {
+	for(std::size_t i = 0; i < count; ++i) {
+		Processor* proc = processors[(pos + i) % count];
+		if(proc->active) {
+			return proc;
+		}
+	}
+	return nullptr;
 }
 
 void rco::Scheduler::GC() {
-	for(Processor* p : processors) {
-		p->gc();
+	std::size_t count = processor_count();
+	for(std::size_t i = 0; i < count; ++i) {
+		processors[i]->gc();
 	}
 }
 
 void rco::Scheduler::update_threshold(size_t n) {
-    if(processors.empty()) return;
-	for(Processor* p : processors) {
-		p->set_threshold(n);
+	std::size_t count = processor_count();
+	for(std::size_t i = 0; i < count; ++i) {
+		processors[i]->set_threshold(n);
+	}
+}
+
+int rco::Scheduler::check_blocking(Load_table& blocking) {
+	std::size_t proc_count = processor_count();
+
+	int active_count = 0;
+	for(std::size_t i = 0; i < proc_count; ++i) {
+		Processor* p = processors[i];
+		// 执行器打上标记, 记录协程切换次数
+		p->make_tag();
+
+		// 不处于等待状态，且当前协程运行时间超过阈值的执行器
+		if(!p->waiting() && p->blocking()) {
+			// 记录阻塞队列 中可执行协程的个数(同时记录其在processor表中的位置)
+			// 其中的协程将被迁移到未阻塞的执行器中
+			blocking.push_back({i, p->runnable_count(), p->load_average()});
+			// p->active p->blocked 只在任务分发线程中更改
+			p->blocked = true;
+			if(p->active) {
+				p->active = false;
+			}
+		} else if(p->blocked) {
+			// 协程已经切出，执行器恢复，等待重新激活
+			p->blocked = false;
+		}
+
+		// 有效的并且已经激活的协程 计数
+		if(p->active) {
+			++ active_count;
+		}
+	}
+
+	return active_count;
+}
+
+void rco::Scheduler::check_preempt() {
+	uint32_t time_slice = config.time_slice;
+
+	// 未开启抢占
+	if(!time_slice) {
+		return;
+	}
+
+	std::size_t proc_count = processor_count();
+	for(std::size_t i = 0; i < proc_count; ++i) {
+		Processor* p = processors[i];
+		// 当前协程运行超过时间片
+		if(!p->waiting() && p->running_time() >= time_slice) {
+			p->preempt();
+		}
 	}
 }
 
 void rco::Scheduler::do_dispatch() {
-	while(running) {
+	while(running.load(std::memory_order_acquire)) {
 
 		// 每1000毫秒调度一次
 		std::this_thread::sleep_for(std::chrono::microseconds(1000));
+		tick = Now_us();
+
+		check_dump();
 
 		// 1. 收集负载值, 记录阻塞状态的p，设置阻塞标记，唤醒处于等待但是有任务的p
-		std::size_t proc_count = processors.size();
-		std::size_t total_load_average = 0;
+		// 负载快照表已在start时预留，不分配内存；队列长度不加锁读取
+		std::size_t proc_count = processor_count();
 
-		using Pos = std::size_t;
 		// 记录激活队列
-		std::multimap<std::size_t, Pos> active;
+		Load_table& active = active_loads;
 		// 记录阻塞队列
-		std::map<Pos, std::size_t> blocking;
+		Load_table& blocking = blocking_loads;
+		active.clear();
+		blocking.clear();
 
-		int active_count = 0;
-		for(std::size_t i = 0; i < proc_count; ++i) {
-			Processor* p = processors[i];
-			// 不处于等待状态但是阻塞的执行器
-			if(!p->waiting() && p->blocking()) {
-				// 记录阻塞队列 中可执行协程的个数(同时记录其在processor表中的位置)
-				blocking[i] = p->runnable_count();
-				// p->active 只在任务分发线程中更改
-				if(p->active) {
-					p->active = false;
-				}
-			}
+		int active_count = check_blocking(blocking);
 
-			// 有效的并且已经激活的协程 计数
-			if(p->active) {
-				++ active_count;
-			}
-		}
+		check_preempt();
 
 		// 能够激活的 执行器(Processor) 个数
 		// proc_count 记录的是激活未阻塞的 执行器
@@ -301,51 +892,68 @@ void rco::Scheduler::do_dispatch() {
 		std::size_t active_task_count = 0;
 		for(std::size_t i = 0; i < proc_count; ++i) {
 			Processor* p = processors[i];
-			// 获取负载值 p` size(ready_queue + runnable_queue)
-			std::size_t load_average = p->runnable_count();
-
-			//	所有执行线程的负载
-			total_load_average += load_average;
+			// 获取负载值 p` size(ready_queue + runnable_queue)，每个周期只读取一次
+			std::size_t depth = p->runnable_count();
+			p->update_load(depth);
 
 			if(!p->active) {
 				// p 未激活，处于等待状态
-				if(canActivated > 0 && (!p->blocking() || p->waiting()) ) {
+				// 已回收的执行器只能通过扩容恢复
+				// 主执行器不会被回收，恢复后总是重新激活，多余的执行器由缩容回收
+				if((canActivated > 0 || i == 0) && !p->blocked && !p->retiring) {
 					// 激活执行器
 					p->active = true;
 					-- canActivated;
-					last_active = i;
 				}
 			}
 
 			if(p->active) {
 				// p 已激活
-				active.insert({load_average, i});
+				active.push_back({i, depth, p->load_average()});
 				// 记录可执行协程的数量
-				active_task_count += p->runnable_count();
-				// 执行器打上标记, 标记该执行器没有阻塞
-				p->make_tag();
+				active_task_count += depth;
 			}
 
 			// 如果该执行器负载不为0（有任务执行），并且为等待状态
-			if(load_average > 0 && p->waiting()) {
+			if(depth > 0 && p->waiting()) {
 				// 唤醒执行器
 				p->notify();
 			}
 
 		}
 
-		// 没有可用的执行器，但是可以创建更多的执行器线程(执行器数量没有达到最大)
-		if(active.empty() && proc_count < max_thread_count) {
-			make_processor_thread();
-			active.insert({0, proc_count});
-			++ proc_count;
+		// 可用的执行器不足(有执行器阻塞)，但是可以创建更多的执行器线程(执行器数量没有达到最大)
+		// 创建(或恢复)执行器接替阻塞的执行器
+		while(active.size() < min_thread_count) {
+			int pos = grow_processor();
+			if(pos < 0) {
+				break;
+			}
+			active.push_back({(std::size_t)pos, 0, 0});
 		}
 
+		// 2. 弹性伸缩
+		// 负载过高，每轮调度最多扩容一个执行器
+		if(need_grow(active, active_task_count)) {
+			int pos = grow_processor();
+			if(pos >= 0) {
+				active.push_back({(std::size_t)pos, 0, 0});
+			}
+		}
+
+		// 回收空闲超时的多余执行器
+		shrink_processor(active);
+
 		// 没有可用执行器，且无法创建新的执行器
 		if(active.empty()) {
 			continue;
 		}
 
+		// 3. 按负载升序排列(可执行协程数相同时，移动平均较小的执行器在前)
+		std::sort(active.begin(), active.end(), [](const Proc_load& a, const Proc_load& b) {
+				return a.depth < b.depth || (a.depth == b.depth && a.avg < b.avg);
+				});
+
 		dispatch_task(active, blocking);
 
 		load_balance(active, active_task_count);
@@ -354,18 +962,21 @@ void rco::Scheduler::do_dispatch() {
 }
 
 
-void rco::Scheduler::dispatch_task(std::multimap<std::size_t, std::size_t>& active, std::map<std::size_t, std::size_t>& blocking) {
+void rco::Scheduler::dispatch_task(Load_table& active, Load_table& blocking) {
 	// 阻塞协程个数为0
-	if(blocking.size() == 0) {
+	if(blocking.empty()) {
 		return;
 	}
 
 	TSList<Task> tasks;
-	for(auto& kv : blocking) {
+	for(const Proc_load& load : blocking) {
 		// 阻塞的执行器
-		Processor* p = processors[kv.first];
+		Processor* p = processors[load.pos];
 		// 偷取全部协程(除了正在运行的协程和下一个要运行的协程)
-		tasks.append(p->steal(0));
+		TSList<Task> stolen = p->steal(0);
+		p->metrics.steals_out.fetch_add(stolen.size(), std::memory_order_relaxed);
+		RCO_TRACE_EVENT(eStealOut, 0, p->id(), stolen.size());
+		tasks.append(std::move(stolen));
 	}
 
 	// 没有可以执行的协程
@@ -373,86 +984,71 @@ void rco::Scheduler::dispatch_task(std::multimap<std::size_t, std::size_t>& acti
 		return;
 	}
 
-	using Pos = uint32_t;
-	// 记录激活队列
-	std::multimap<std::size_t, Pos> new_active;
-	// 协程总数
+	// 从负载最小的执行器开始平分协程，直到执行器的负载超过平分后的协程数
+	// 协程总数(待分配的协程 + 参与平分的执行器中的协程)
 	std::size_t total_task_count = tasks.size();
 	// 需要平分协程的processor的数量
 	std::size_t devide_num = 0;
-	// 平分的协程数量
-	std::size_t avg = 0;
-
-	auto needDevide_proc = active.begin();
-	for(; needDevide_proc != active.end(); ++needDevide_proc) {
-		// needDevide_proc->first 就是该processor中可以执行的协程数量
-		total_task_count += needDevide_proc->first;
-
-		// 需要平分协程的processor的数量增加
-		++devide_num;
-
-		// 计算出平分的协程数
-		avg = total_task_count / devide_num;
-
-		// 如果该执行器中可执行的协程数量大于平分数，则将其移除
-		if(needDevide_proc->first > avg) {
-
-			// 协程总数更新
-			total_task_count -= needDevide_proc->first;
-			// 需要平分协程的processor的数量更新
-			--devide_num;
-			// 重新计算平分协程数
-			avg = total_task_count / devide_num;
+	for(; devide_num < active.size(); ++devide_num) {
+		std::size_t depth = active[devide_num].depth;
+		// 如果该执行器中可执行的协程数量大于加入它之后的平分数，则停止
+		if(depth * (devide_num + 1) > total_task_count + depth) {
 			break;
 		}
+		total_task_count += depth;
+	}
 
-		if(needDevide_proc != active.end()) {
-			++needDevide_proc;
+	// 平分的协程数量
+	std::size_t avg = total_task_count / devide_num;
+
+	for(std::size_t i = 0; i < devide_num && !tasks.empty(); ++i) {
+		if(active[i].depth >= avg) {
+			continue;
 		}
 
-		auto it = active.begin();
-		for(; it != needDevide_proc; ++it) {
-			// 保证需要分配协程的执行器都有平均数个协程
-			TSList<Task> target_list = tasks.truncation(avg - it->first);
+		// 保证需要分配协程的执行器都有平均数个协程
+		TSList<Task> target_list = tasks.truncation(avg - active[i].depth);
 
-			if(target_list.empty()) {
-				break;
-			}
-
-			Processor* proc = processors[it->second];
-			if(proc) {
-				proc->add_task(std::move(target_list));
-			}
-		}
+		Processor* p = processors[active[i].pos];
+		p->metrics.steals_in.fetch_add(target_list.size(), std::memory_order_relaxed);
+		RCO_TRACE_EVENT(eStealIn, 0, p->id(), target_list.size());
+		add_tasks(p, std::move(target_list));
+	}
 
-		if(!tasks.empty()) {
-			Processor* proc = processors[active.begin()->second];
-			proc->add_task(std::move(tasks));
-		}
+	// 剩余的协程(除法余数)交给负载最小的执行器
+	if(!tasks.empty()) {
+		Processor* proc = processors[active.front().pos];
+		proc->metrics.steals_in.fetch_add(tasks.size(), std::memory_order_relaxed);
+		RCO_TRACE_EVENT(eStealIn, 0, proc->id(), tasks.size());
+		add_tasks(proc, std::move(tasks));
 	}
 }
 
-void rco::Scheduler::load_balance(std::multimap<std::size_t, std::size_t>& active, std::size_t active_tasks) {
+void rco::Scheduler::load_balance(Load_table& active, std::size_t active_tasks) {
 
 	// 激活的平均协程数
 	std::size_t avg = active_tasks / active.size();
 
-	if(active.begin()->first > (avg * Runtime::Load_balance_rate()) ) {
+	if(active.front().depth > (avg * config.load_balance_rate) ) {
 		return;
 	}
 
 	TSList<Task> tasks;
-	for(auto it = active.rbegin(); it != active.rend(); ++it) {
+	// 从负载最高的执行器开始
+	for(std::size_t i = active.size(); i > 0; --i) {
+		const Proc_load& load = active[i - 1];
 		// 执行器的可执行协程数小于平均值
-		if(it->first <= avg) {
+		if(load.depth <= avg) {
 			// 直接跳出
 			break;
 		}
 
-		Processor* p = processors[it->second];
+		Processor* p = processors[load.pos];
 
 		// 取出大于平均数的协程
-		TSList<Task> target_list = p->steal(it->first - avg);
+		TSList<Task> target_list = p->steal(load.depth - avg);
+		p->metrics.steals_out.fetch_add(target_list.size(), std::memory_order_relaxed);
+		RCO_TRACE_EVENT(eStealOut, 0, p->id(), target_list.size());
 
 		tasks.append(std::move(target_list));
 	}
@@ -462,22 +1058,26 @@ void rco::Scheduler::load_balance(std::multimap<std::size_t, std::size_t>& activ
 		return;
 	}
 
-	for(auto& kv : active) {
-		if(kv.first >= avg) {
+	for(const Proc_load& load : active) {
+		if(load.depth >= avg || tasks.empty()) {
 			break;
 		}
 
-		Processor* p = processors[kv.second];
+		Processor* p = processors[load.pos];
 
 		// 此时，已经确保执行器的可执行协程数少于平均数
-		TSList<Task> target_list = tasks.truncation(avg - kv.first);
+		TSList<Task> target_list = tasks.truncation(avg - load.depth);
 
-		p->add_task(std::move(target_list));
+		p->metrics.steals_in.fetch_add(target_list.size(), std::memory_order_relaxed);
+		RCO_TRACE_EVENT(eStealIn, 0, p->id(), target_list.size());
+		add_tasks(p, std::move(target_list));
 	}
 
 	if(!tasks.empty()) {
-		Processor* p = processors[active.begin()->second];
-		p->add_task(std::move(tasks));
+		Processor* p = processors[active.front().pos];
+		p->metrics.steals_in.fetch_add(tasks.size(), std::memory_order_relaxed);
+		RCO_TRACE_EVENT(eStealIn, 0, p->id(), tasks.size());
+		add_tasks(p, std::move(tasks));
 	}
 
 }
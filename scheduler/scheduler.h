@@ -2,12 +2,23 @@
 
 #include "../common/internal.h"
 #include "../common/noncopyable.h"
+#include "../rcds/tslist.h"
 #include "../task/task.h"
 
-#include <deque>
-#include <map>
+#include "blocking_pool.h"
+#include "config.h"
+#include "introspect.h"
+#include "metrics.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <functional>
 #include <mutex>
+#include <ostream>
 #include <thread>
+#include <vector>
 
 namespace rco {
 
@@ -20,6 +31,7 @@ namespace rco {
 	class Scheduler : public Noncopyable {
 		friend Processor;
 		friend Runtime;
+		friend void blocking(const std::function<void()>& fn);
 		public:
 
 		/**
@@ -30,19 +42,93 @@ namespace rco {
 		RCO_STATIC Scheduler& Instance();
 
 		/**
-		 * @brief 创建调度器
+		 * @brief 创建调度器(使用Runtime中的默认配置)
+		 *
+		 * 调度器在进程退出时回收，只回收已关闭(shutdown)且执行器已释放的调度器
 		 *
 		 * @return 调度器对象
 		 */
 		RCO_STATIC Scheduler* Make();
 
+		/**
+		 * @brief 创建调度器，调度器之间相互独立(执行器、阻塞调用线程池、协程id、配置)
+		 *
+		 * @param[in] config 调度器配置
+		 *
+		 * @return 调度器对象
+		 */
+		RCO_STATIC Scheduler* Make(const Sched_config& config);
+
+		/**
+		 * @brief 获取调度器id(进程内唯一)
+		 *
+		 * @return 调度器id
+		 */
+		RCO_INLINE uint16_t id() const {
+			return sched_id;
+		}
+
+		/**
+		 * @brief 获取调度器配置
+		 *
+		 * @return 调度器配置
+		 */
+		RCO_INLINE const Sched_config& get_config() const {
+			return config;
+		}
+
+		/**
+		 * @brief 向阻塞调用线程池投递任务，不挂起当前协程(用于自行等待结果的场景，如 co_task)
+		 *
+		 * @param[in] job 任务
+		 */
+		RCO_INLINE void post_blocking(Blocking_pool::Job&& job) {
+			blocking_pool.post(std::move(job));
+		}
+
 		/**
 		 * @brief 创建协程
 		 *
 		 * @param[in] execute 执行任务实体
 		 * @param[in] attr	  协程属性
+		 *
+		 * @return 成功 ? true : false(调度器正在关闭，不再接受新的协程)
+		 */
+		bool make_task(const Task::Execute& execute, const Task::Attribute& attr);
+
+		/**
+		 * @brief 预留未完成的协程数，用于稍后才创建的协程(如在其他线程中恢复的 co_task)：
+		 *		  预留之后关闭过程会等待这些协程创建并执行完毕
+		 *
+		 * @param[in] n 协程个数
+		 *
+		 * @return 成功 ? true : false(调度器正在关闭，不再接受新的协程)
+		 */
+		bool reserve_task(uint32_t n = 1);
+
+		/**
+		 * @brief 使用 reserve_task 的预留创建协程，不再检查是否接受(可在任意线程中调用)
+		 *
+		 * @param[in] execute 执行任务实体
+		 * @param[in] attr	  协程属性
 		 */
-		void make_task(const Task::Execute& execute, const Task::Attribute& attr);
+		void make_reserved_task(const Task::Execute& execute, const Task::Attribute& attr);
+
+		typedef std::function<void(std::size_t)> Batch_execute;
+
+		/**
+		 * @brief 批量创建协程，第 i 个协程执行 execute(i)
+		 *
+		 * 协程按激活的执行器平分，每个执行器的一批协程链接为列表后一次加锁放入就绪队列，
+		 * 创建 N 个协程的加锁与唤醒次数由 O(N) 降为 O(执行器数)
+		 *
+		 * @param[in] count	  协程个数
+		 * @param[in] execute 执行任务实体(各协程共享同一份)
+		 * @param[in] attr	  协程属性
+		 *
+		 * @return 成功 ? true : false(调度器正在关闭，不再接受新的协程)
+		 */
+		bool make_tasks(std::size_t count, const Batch_execute& execute, const Task::Attribute& attr);
 
 		/**
 		 * @brief 是否在执行协程中
@@ -63,18 +149,96 @@ namespace rco {
 		 *
 		 * @param[in] min_thread_cnt 最小线程数
 		 * @param[in] max_thread_cnt 最大线程数
+		 * @param[in] background	 后台模式：主执行器运行在新线程上，函数立即返回；
+		 *							 否则调用线程作为主执行器，直到调度停止才返回
 		 */
-		void start(uint16_t min_thread_cnt, uint16_t max_thread_cnt);
+		void start(uint16_t min_thread_cnt, uint16_t max_thread_cnt, bool background = false);
 
 		/**
-		 * @brief 停止调度
+		 * @brief 停止调度(立即停止，不等待协程执行完毕)
 		 */
 		void stop();
 
+		/**
+		 * @brief 关闭调度器：不再接受外部创建的协程(调度器内协程创建的协程仍被接受)，
+		 *		  等待所有协程执行完毕，超时后停止调度并取消剩余协程，
+		 *		  等待所有执行器线程、阻塞调用线程池退出，之后释放执行器及其缓存的协程栈
+		 *		  (有线程未能退出时不释放)；调度器对象本身在进程退出时回收
+		 *
+		 *		  在本调度器的协程中调用时，关闭过程在新线程中异步进行，函数立即返回false
+		 *
+		 * @param[in] timeout 等待协程执行完毕的超时时间
+		 *
+		 * @return 所有协程正常执行完毕且所有线程已退出 ? true : false
+		 */
+		bool shutdown(std::chrono::milliseconds timeout);
+
+		/**
+		 * @brief 执行器伸缩统计
+		 */
+		struct Resize_stats {
+			uint16_t threads;		// 运行中的执行器线程数
+			uint16_t active;		// 激活的执行器数
+			uint16_t peak;			// 执行器线程数峰值
+			uint64_t grow_count;	// 扩容次数
+			uint64_t shrink_count;	// 缩容次数
+			uint64_t last_resize;	// 最近一次伸缩的时刻(单调时钟，微秒)
+		};
+
+		/**
+		 * @brief 获取执行器伸缩统计
+		 *
+		 * @return 统计信息
+		 */
+		Resize_stats resize_stats();
+
+		/**
+		 * @brief 获取调度器指标快照(各执行器的计数器、队列长度与耗时直方图)
+		 *
+		 * @return 快照
+		 */
+		Sched_stats stats();
+
+		/**
+		 * @brief 获取所有存活协程的快照，按执行器排列
+		 *
+		 * 快照在协程运行时获取，只保证每个协程的信息各自一致；
+		 * 调用栈沿帧指针回溯，需要以 -fno-omit-frame-pointer 编译；输出时解析函数名需要导出符号(-rdynamic / ENABLE_EXPORTS)
+		 *
+		 * @param[in] max_frames 每个协程最多回溯的调用栈层数
+		 *
+		 * @return 快照
+		 */
+		std::vector<Task_info> tasks(std::size_t max_frames = 32);
+
+		/**
+		 * @brief 输出所有存活协程的快照
+		 *
+		 * @param[in] os 输出流
+		 */
+		void dump_tasks(std::ostream& os);
+
+		/**
+		 * @brief 安装协程快照信号：收到信号后，各调度器的分发线程将协程快照输出到标准错误
+		 *
+		 * 信号处理函数只设置标志，快照在分发线程中获取，分发线程每个调度周期检查一次
+		 *
+		 * @param[in] sig 信号(如 SIGUSR2)
+		 */
+		RCO_STATIC void InstallDumpSignal(int sig);
+
 		private:
 		Scheduler();
+		explicit Scheduler(const Sched_config& config);
 		~Scheduler();
 
+		/**
+		 * @brief 按配置将执行器线程绑定到CPU集合
+		 *
+		 * @param[in] th 执行器线程
+		 */
+		void bind_cpus(std::thread& th);
+
 		/**
 		 * @brief 添加协程到相应的执行器中
 		 *
@@ -82,11 +246,133 @@ namespace rco {
 		 */
 		void add_task(Task* task);
 
+		/**
+		 * @brief 批量添加协程到执行器，执行器已被回收时按放置策略重新选择
+		 *
+		 * @param[in] proc	目标执行器
+		 * @param[in] tasks 协程列表
+		 */
+		void add_tasks(Processor* proc, TSList<Task>&& tasks);
+
+		/**
+		 * @brief 创建协程对象并登记(id、计数、指标)，不放入执行器
+		 *
+		 * @param[in] execute 执行任务实体
+		 * @param[in] attr	  协程属性
+		 *
+		 * @return 协程对象
+		 */
+		Task* new_task(const Task::Execute& execute, const Task::Attribute& attr);
+
+		/**
+		 * @brief 创建协程前的公共准备：安装栈访问异常处理，补全协程属性(栈剖析、创建位置)
+		 *
+		 * @param[in] attr		 协程属性
+		 * @param[in] spawn_site 未指定创建位置时使用的地址(创建接口的调用者)
+		 *
+		 * @return 补全后的协程属性
+		 */
+		Task::Attribute task_attribute(const Task::Attribute& attr, void* spawn_site);
+
+		/**
+		 * @brief 按放置策略(config.placement)为新协程选择执行器
+		 *
+		 * @return 执行器，没有激活的执行器时为主执行器
+		 */
+		Processor* place_task();
+
+		/**
+		 * @brief 从指定位置开始查找激活的执行器
+		 *
+		 * @param[in] pos	起始位置
+		 * @param[in] count 执行器个数
+		 *
+		 * @return 执行器，没有激活的执行器时为nullptr
+		 */
+		Processor* active_processor(std::size_t pos, std::size_t count);
+
+		/**
+		 * @brief 协程执行完毕(或被取消)，减少未完成的协程数
+		 *
+		 * @param[in] n 协程数
+		 */
+		void task_finished(uint32_t n = 1);
+
+		/**
+		 * @brief 丢弃未执行完毕的协程(调度器已停止)，与执行完毕的协程一样减少未完成的协程数
+		 *
+		 * @param[in] task 协程对象
+		 */
+		void drop_task(Task* task);
+
+		/**
+		 * @brief 等待所有执行器退出调度，超时未退出的执行器线程将被分离
+		 *
+		 * @param[in] deadline 截止时刻
+		 *
+		 * @return 所有执行器都已退出 ? true : false
+		 */
+		bool join_processors(std::chrono::steady_clock::time_point deadline);
+
+		/**
+		 * @brief 释放所有执行器(包括缓存的协程栈)，之后执行器个数为 0
+		 *
+		 *		  只在关闭过程中、所有执行器线程与阻塞调用线程都已退出后调用
+		 */
+		void release_processors();
+
 		/**
 		 * @brief 创建执行器线程(processor 与 thread 为 1 : 1)
 		 */
 		void make_processor_thread();
 
+		/**
+		 * @brief 扩容：优先恢复已回收的执行器，否则在未达到最大线程数时创建新的执行器
+		 *
+		 * @return 执行器在processor表中的位置，无法扩容时为-1
+		 */
+		int grow_processor();
+
+		/**
+		 * @brief 分发线程中执行器的负载快照
+		 */
+		struct Proc_load {
+			std::size_t pos;	// 在processor表中的位置
+			std::size_t depth;	// 可执行协程数(包括正在运行的协程)
+			uint32_t	avg;	// 可执行协程数的移动平均(Processor::load_average)
+		};
+
+		/**
+		 * @brief 负载快照表，start时按最大线程数预留，分发过程中不分配内存
+		 */
+		using Load_table = std::vector<Proc_load>;
+
+		/**
+		 * @brief 根据负载判断是否需要扩容
+		 *
+		 * @param[in] active	  激活的执行器
+		 * @param[in] active_tasks 激活的执行器中可执行协程总数
+		 *
+		 * @return 是 ? true : false
+		 */
+		bool need_grow(Load_table& active, std::size_t active_tasks);
+
+		/**
+		 * @brief 缩容：回收空闲超时的多余执行器
+		 *
+		 * @param[in,out] active 激活的执行器，被回收的执行器将从中移除
+		 */
+		void shrink_processor(Load_table& active);
+
+		/**
+		 * @brief 获取已创建的执行器个数
+		 *
+		 * @return 执行器个数
+		 */
+		RCO_INLINE std::size_t processor_count() const {
+			return proc_count.load(std::memory_order_acquire);
+		}
+
 		/**
 		 * @brief 删除协程
 		 *
@@ -123,27 +409,84 @@ namespace rco {
 		 */
 		void update_threshold(size_t n);
 
+		/**
+		 * @brief 检测阻塞的执行器：比较协程切换次数与上次标记，
+		 *		  当前协程运行时间超过阈值的执行器被标记为阻塞并取消激活
+		 *
+		 * @param[out] blocking 阻塞的执行器
+		 *
+		 * @return 激活的执行器个数
+		 */
+		int check_blocking(Load_table& blocking);
+
+		/**
+		 * @brief 检测运行超过时间片的协程并请求抢占
+		 */
+		void check_preempt();
+
+		/**
+		 * @brief 收到快照信号后输出协程快照(分发线程中调用)
+		 */
+		void check_dump();
+
 		void do_dispatch();
 
-		void dispatch_task(std::multimap<std::size_t, std::size_t>& active, std::map<std::size_t, std::size_t>& blocking);
-		void load_balance(std::multimap<std::size_t, std::size_t>& active, std::size_t active_tasks);
+		/**
+		 * @brief 将阻塞的执行器中的协程平分给负载最小的执行器
+		 *
+		 * @param[in] active   激活的执行器(按负载升序)
+		 * @param[in] blocking 阻塞的执行器
+		 */
+		void dispatch_task(Load_table& active, Load_table& blocking);
+
+		/**
+		 * @brief 负载均衡：负载高于平均值的执行器将多余的协程移给低于平均值的执行器
+		 *
+		 * @param[in] active	  激活的执行器(按负载升序)
+		 * @param[in] active_tasks 激活的执行器中可执行协程总数
+		 */
+		void load_balance(Load_table& active, std::size_t active_tasks);
 		private:
-		bool running;
+		std::atomic<bool> running;	// 是否正在调度(stop/shutdown 在其他线程中修改)
 
 		Spin_lock started;
 
-		std::deque<Processor*> processors;
-		std::mutex			   mutex;
+		std::vector<Processor*> processors;	// 执行器表(start时预留最大线程数，不会重新分配)
+		std::atomic<uint16_t>	proc_count;	// 已创建的执行器个数
+		Load_table				active_loads;	// 激活的执行器负载(只在分发线程中使用)
+		Load_table				blocking_loads; // 阻塞的执行器负载(只在分发线程中使用)
+		std::mutex				mutex;
 
 		std::thread timer_thread;
 		std::thread dispatch_thread;
 
 		std::atomic<uint32_t> task_count;
+		std::atomic<uint32_t> unfinished;	// 未执行完毕的协程数
 
-		volatile uint32_t last_active;
+		std::atomic<bool>		accepting;	// 是否接受外部创建的协程(关闭时为false)
+		volatile bool			launched;	// 是否已经开始调度
+		bool					finished;	// 关闭完成
+		bool					released;	// 执行器已释放(关闭完成且所有线程已退出)
+		std::mutex				drain_mutex;
+		std::condition_variable	drain_cv;	// 协程全部执行完毕 / 关闭完成
+
+		volatile uint64_t tick;			// 调度时刻(分发线程每轮调度时更新，微秒)
+
+		uint16_t		  sched_id;		// 调度器id
+		sig_atomic_t	  dump_seen;	// 已处理的快照请求
+		std::atomic<uint64_t> task_seed;// 协程id生成
+
+		Sched_config  config;			// 调度器配置
+
+		Blocking_pool blocking_pool;	// 阻塞调用线程池
 
 		uint16_t min_thread_count;
 		uint16_t max_thread_count;
+
+		uint16_t			  peak_thread_count;
+		std::atomic<uint64_t> grow_count;
+		std::atomic<uint64_t> shrink_count;
+		std::atomic<uint64_t> last_resize;
 	};
 
 }
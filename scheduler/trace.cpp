@@ -0,0 +1,336 @@
+#include "trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+
+#include <unistd.h>
+
+#include "processor.h"
+#include "scheduler.h"
+
+namespace {
+	/**
+	 * @brief 线程的环形缓冲区，只由所属线程写入
+	 */
+	struct Trace_buffer {
+		std::unique_ptr<rco::Trace_record[]> ring;
+		size_t				  capacity;		// 2 的幂
+		std::atomic<uint64_t> head;			// 已写入的事件总数
+		uint64_t			  generation;	// 所属的记录批次(Start/Reset)
+		uint32_t			  tid;
+		std::string			  name;
+		bool				  in_use;		// 所属线程未退出(退出后由新线程复用)
+	};
+
+	struct Trace_state {
+		std::mutex	mutex;
+		std::vector<std::unique_ptr<Trace_buffer>> buffers;
+
+		std::atomic<uint64_t> generation{1};
+		size_t		capacity = 1 << 16;
+		uint32_t	next_tid = 1;
+
+		// 时间戳计数器的校准点
+		uint64_t	tsc_begin = 0;
+		uint64_t	ns_begin = 0;
+		uint64_t	tsc_end = 0;
+		uint64_t	ns_end = 0;
+	};
+
+	Trace_state& State() {
+		RCO_STATIC Trace_state s_state;
+		return s_state;
+	}
+
+	thread_local Trace_buffer* tl_buffer = nullptr;
+
+	/**
+	 * @brief 线程退出时归还缓冲区，阻塞调用线程池等线程反复创建时缓冲区数量不超过同时存在的线程数
+	 */
+	struct Buffer_owner {
+		~Buffer_owner() {
+			if(!tl_buffer) {
+				return;
+			}
+			Trace_state& state = State();
+			std::unique_lock<std::mutex> scope_lock(state.mutex);
+			tl_buffer->in_use = false;
+			tl_buffer = nullptr;
+		}
+		bool registered = false;
+	};
+
+	thread_local Buffer_owner tl_owner;
+
+	size_t Round_capacity(size_t n) {
+		size_t capacity = 1024;
+		while(capacity < n) {
+			capacity <<= 1;
+		}
+		return capacity;
+	}
+
+	/**
+	 * @brief 获取当前线程本批次的缓冲区，容量不变时复用之前的缓冲区
+	 */
+	Trace_buffer* Thread_buffer() {
+		Trace_state& state = State();
+		uint64_t generation = state.generation.load(std::memory_order_acquire);
+		if(aco_likely(tl_buffer && tl_buffer->generation == generation)) {
+			return tl_buffer;
+		}
+
+		std::unique_lock<std::mutex> scope_lock(state.mutex);
+		generation = state.generation.load(std::memory_order_relaxed);
+		if(tl_buffer && tl_buffer->capacity == state.capacity) {
+			tl_buffer->head.store(0, std::memory_order_relaxed);
+			tl_buffer->generation = generation;
+			return tl_buffer;
+		}
+
+		// 旧缓冲区只有当前线程会写入，可以直接释放；已退出线程的、容量不同的缓冲区不会再被复用，同样释放
+		state.buffers.erase(std::remove_if(state.buffers.begin(), state.buffers.end(),
+					[&state](const std::unique_ptr<Trace_buffer>& b) {
+						return b.get() == tl_buffer || (!b->in_use && b->capacity != state.capacity);
+					}), state.buffers.end());
+
+		// 优先复用已退出线程的、不属于本批次的缓冲区；都属于本批次时仍然复用(覆盖已退出线程的事件)
+		Trace_buffer* buffer = nullptr;
+		for(const std::unique_ptr<Trace_buffer>& b : state.buffers) {
+			if(!b->in_use && (!buffer || buffer->generation == generation)) {
+				buffer = b.get();
+			}
+		}
+		if(!buffer) {
+			std::unique_ptr<Trace_buffer> created(new Trace_buffer);
+			created->ring.reset(new rco::Trace_record[state.capacity]);
+			created->capacity = state.capacity;
+			buffer = created.get();
+			state.buffers.push_back(std::move(created));
+		}
+		buffer->in_use = true;
+		buffer->head.store(0, std::memory_order_relaxed);
+		buffer->generation = generation;
+		buffer->tid = state.next_tid++;
+
+		// 可能运行在协程栈上，不使用 iostream
+		char name[48];
+		rco::Processor* proc = rco::Processor::CurrentProcessor();
+		if(proc) {
+			snprintf(name, sizeof(name), "rco processor %u.%u", proc->belong_scheduler()->id(), proc->id());
+		} else {
+			snprintf(name, sizeof(name), "thread %u", buffer->tid);
+		}
+		buffer->name = name;
+
+		tl_buffer = buffer;
+		tl_owner.registered = true;
+		return tl_buffer;
+	}
+
+	const char* End_reason(rco::Trace_event event) {
+		switch(event) {
+			case rco::Trace_event::eYield:
+				return "yield";
+			case rco::Trace_event::ePark:
+				return "park";
+			default:
+				return "finish";
+		}
+	}
+
+	/**
+	 * @brief 协程id格式化为 调度器id:序号
+	 */
+	std::string Task_name(uint64_t id) {
+		std::ostringstream os;
+		os << (id >> 48) << ":" << (id & ((1ull << 48) - 1));
+		return os.str();
+	}
+}
+
+std::atomic<bool> rco::Trace::enabled(false);
+
+uint64_t rco::Trace::Steady_ns() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void rco::Trace::Start(size_t capacity) {
+	Trace_state& state = State();
+	{
+		std::unique_lock<std::mutex> scope_lock(state.mutex);
+		state.capacity = Round_capacity(capacity);
+		state.tsc_begin = Tsc();
+		state.ns_begin = Steady_ns();
+		state.tsc_end = 0;
+		state.ns_end = 0;
+		// 新的批次，各线程在下一次记录时清空自己的缓冲区
+		state.generation.fetch_add(1, std::memory_order_release);
+	}
+	enabled = true;
+}
+
+void rco::Trace::Stop() {
+	enabled = false;
+
+	Trace_state& state = State();
+	std::unique_lock<std::mutex> scope_lock(state.mutex);
+	state.tsc_end = Tsc();
+	state.ns_end = Steady_ns();
+}
+
+void rco::Trace::Reset() {
+	Trace_state& state = State();
+	std::unique_lock<std::mutex> scope_lock(state.mutex);
+	state.generation.fetch_add(1, std::memory_order_release);
+	state.tsc_begin = Tsc();
+	state.ns_begin = Steady_ns();
+}
+
+void rco::Trace::Record(Trace_event event, uint64_t task, uint16_t proc, uint32_t arg) {
+	Trace_buffer* buffer = Thread_buffer();
+	uint64_t head = buffer->head.load(std::memory_order_relaxed);
+
+	Trace_record& record = buffer->ring[head & (buffer->capacity - 1)];
+	record.tsc = Tsc();
+	record.task = task;
+	record.arg = arg;
+	record.proc = proc;
+	record.event = event;
+
+	buffer->head.store(head + 1, std::memory_order_release);
+}
+
+void rco::Trace::Dump(std::ostream& os) {
+	struct Entry {
+		uint64_t	 tsc;
+		uint32_t	 tid;
+		Trace_record record;
+	};
+
+	Trace_state& state = State();
+	std::unique_lock<std::mutex> scope_lock(state.mutex);
+
+	uint64_t generation = state.generation.load(std::memory_order_relaxed);
+	std::vector<Entry> entries;
+	std::vector<const Trace_buffer*> threads;
+	for(const std::unique_ptr<Trace_buffer>& buffer : state.buffers) {
+		if(buffer->generation != generation) {
+			continue;
+		}
+		threads.push_back(buffer.get());
+
+		uint64_t head = buffer->head.load(std::memory_order_acquire);
+		uint64_t begin = head > buffer->capacity ? head - buffer->capacity : 0;
+		for(uint64_t i = begin; i < head; ++i) {
+			const Trace_record& record = buffer->ring[i & (buffer->capacity - 1)];
+			entries.push_back(Entry{record.tsc, buffer->tid, record});
+		}
+	}
+
+	// 按时间合并所有线程的事件，以便关联跨线程的唤醒与切入
+	std::stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+			return a.tsc < b.tsc;
+			});
+
+	// 时间戳计数器换算为微秒
+	uint64_t tsc_end = state.tsc_end ? state.tsc_end : Tsc();
+	uint64_t ns_end = state.ns_end ? state.ns_end : Steady_ns();
+	double ns_per_tick = 1.0;
+	if(tsc_end > state.tsc_begin && ns_end > state.ns_begin) {
+		ns_per_tick = double(ns_end - state.ns_begin) / double(tsc_end - state.tsc_begin);
+	}
+	uint64_t tsc_begin = state.tsc_begin;
+	if(!entries.empty() && entries.front().tsc < tsc_begin) {
+		tsc_begin = entries.front().tsc;
+	}
+
+	int pid = getpid();
+	bool first = true;
+	auto begin_event = [&](const char* ph, const std::string& name, uint32_t tid, uint64_t tsc) {
+		os << (first ? "\n" : ",\n");
+		first = false;
+		os << "{\"name\":\"" << name << "\",\"ph\":\"" << ph << "\",\"pid\":" << pid
+		   << ",\"tid\":" << tid << ",\"ts\":" << double(tsc - tsc_begin) * ns_per_tick / 1000.0;
+	};
+
+	os << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+
+	for(const Trace_buffer* thread : threads) {
+		os << (first ? "\n" : ",\n");
+		first = false;
+		os << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << thread->tid
+		   << ",\"args\":{\"name\":\"" << thread->name << "\"}}";
+	}
+
+	// 线程上是否有未结束的运行区间(缓冲区覆盖后开头的结束事件没有对应的切入事件)
+	std::unordered_map<uint32_t, bool> running;
+	// 已被唤醒或创建、尚未切入的协程，切入时以 flow 事件连接
+	std::unordered_map<uint64_t, const char*> pending;
+
+	for(const Entry& entry : entries) {
+		const Trace_record& record = entry.record;
+		std::string task = Task_name(record.task);
+
+		switch(record.event) {
+			case Trace_event::eSpawn:
+			case Trace_event::eWake: {
+				const char* name = record.event == Trace_event::eSpawn ? "spawn" : "wake";
+				begin_event("i", name, entry.tid, entry.tsc);
+				os << ",\"s\":\"t\",\"args\":{\"task\":\"" << task << "\",\"proc\":" << record.proc << "}}";
+				begin_event("s", name, entry.tid, entry.tsc);
+				os << ",\"cat\":\"queue\",\"id\":\"" << task << "\"}";
+				pending[record.task] = name;
+				break;
+			}
+			case Trace_event::eResume: {
+				running[entry.tid] = true;
+				begin_event("B", "task " + task, entry.tid, entry.tsc);
+				os << ",\"args\":{\"task\":\"" << task << "\",\"proc\":" << record.proc << "}}";
+
+				auto it = pending.find(record.task);
+				if(it != pending.end()) {
+					begin_event("f", it->second, entry.tid, entry.tsc);
+					os << ",\"cat\":\"queue\",\"bp\":\"e\",\"id\":\"" << task << "\"}";
+					pending.erase(it);
+				}
+				break;
+			}
+			case Trace_event::eYield:
+			case Trace_event::ePark:
+			case Trace_event::eFinish:
+				if(!running[entry.tid]) {
+					break;
+				}
+				running[entry.tid] = false;
+				begin_event("E", "task " + task, entry.tid, entry.tsc);
+				os << ",\"args\":{\"end\":\"" << End_reason(record.event) << "\"}}";
+				break;
+			case Trace_event::eStealOut:
+			case Trace_event::eStealIn:
+				begin_event("i", record.event == Trace_event::eStealOut ? "steal out" : "steal in", entry.tid, entry.tsc);
+				os << ",\"s\":\"t\",\"args\":{\"proc\":" << record.proc << ",\"tasks\":" << record.arg << "}}";
+				break;
+		}
+	}
+
+	os << "\n]}\n";
+	os.flush();
+}
+
+bool rco::Trace::Dump(const std::string& path) {
+	std::ofstream ofs(path);
+	if(!ofs) {
+		return false;
+	}
+	Dump(ofs);
+	return !!ofs;
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#include "../common/internal.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace rco {
+
+	/**
+	 * @brief 调度事件
+	 */
+	enum class Trace_event : uint8_t {
+		eSpawn,		// 创建协程
+		eResume,	// 协程切入
+		eYield,		// 协程切出(仍可运行)
+		ePark,		// 协程挂起(CoPark)
+		eWake,		// 唤醒挂起的协程(CoWake)
+		eStealOut,	// 负载均衡移出协程(arg为数量)
+		eStealIn,	// 负载均衡移入协程(arg为数量)
+		eFinish,	// 协程执行完毕
+	};
+
+	/**
+	 * @brief 事件记录
+	 */
+	struct Trace_record {
+		uint64_t	tsc;		// 时间戳计数器
+		uint64_t	task;		// 协程id(负载均衡事件为0)
+		uint32_t	arg;		// 附加参数
+		uint16_t	proc;		// 执行器id
+		Trace_event	event;
+	};
+
+	/**
+	 * @brief 调度事件跟踪
+	 *
+	 * 每个线程一个环形缓冲区，写入时不加锁，缓冲区写满后覆盖最早的事件；
+	 * 事件点只在以 RCO_TRACE 编译时存在(RCO_TRACE_EVENT)，否则不产生任何代码。
+	 * 输出为 Chrome trace JSON，可在 chrome://tracing 或 Perfetto(ui.perfetto.dev)中打开
+	 */
+	class Trace {
+		public:
+			Trace() = delete;
+
+			/**
+			 * @brief 开始记录，清空之前的事件
+			 *
+			 * @param[in] capacity 每个线程缓冲区的事件数(向上取整为 2 的幂)
+			 */
+			RCO_STATIC void Start(size_t capacity = 1 << 16);
+
+			/**
+			 * @brief 停止记录，已记录的事件保留到下一次 Start/Reset
+			 */
+			RCO_STATIC void Stop();
+
+			RCO_STATIC RCO_INLINE bool Enabled() {
+				return enabled.load(std::memory_order_relaxed);
+			}
+
+			/**
+			 * @brief 读取时间戳计数器(x86 为 rdtsc，aarch64 为 cntvct_el0，其他平台为单调时钟纳秒)
+			 */
+			RCO_STATIC RCO_INLINE uint64_t Tsc() {
+#if defined(__x86_64__) || defined(__i386__)
+				return __rdtsc();
+#elif defined(__aarch64__)
+				uint64_t v;
+				asm volatile("mrs %0, cntvct_el0" : "=r"(v));
+				return v;
+#else
+				return Steady_ns();
+#endif
+			}
+
+			/**
+			 * @brief 记录事件(未开始记录时忽略)
+			 *
+			 * @param[in] event 事件
+			 * @param[in] task  协程id
+			 * @param[in] proc  执行器id
+			 * @param[in] arg   附加参数
+			 */
+			RCO_STATIC RCO_INLINE void Emit(Trace_event event, uint64_t task, uint16_t proc, uint32_t arg = 0) {
+				if(aco_likely(!Enabled())) {
+					return;
+				}
+				Record(event, task, proc, arg);
+			}
+
+			/**
+			 * @brief 输出 Chrome trace JSON，应在 Stop 之后调用，否则正在写入的事件可能不完整
+			 *
+			 * @param[in] os 输出流
+			 */
+			RCO_STATIC void Dump(std::ostream& os);
+
+			/**
+			 * @brief 输出到文件
+			 *
+			 * @param[in] path 文件路径
+			 *
+			 * @return 成功 ? true : false
+			 */
+			RCO_STATIC bool Dump(const std::string& path);
+
+			/**
+			 * @brief 清空所有线程的缓冲区
+			 */
+			RCO_STATIC void Reset();
+
+		private:
+			RCO_STATIC RCO_NOINLINE void Record(Trace_event event, uint64_t task, uint16_t proc, uint32_t arg);
+
+			RCO_STATIC uint64_t Steady_ns();
+
+		private:
+			RCO_STATIC std::atomic<bool> enabled;
+	};
+}
+
+#if defined(RCO_TRACE)
+	#define RCO_TRACE_EVENT(event, task, proc, arg) \
+		::rco::Trace::Emit(::rco::Trace_event::event, (task), (proc), (arg))
+#else
+	#define RCO_TRACE_EVENT(event, task, proc, arg) ((void)0)
+#endif
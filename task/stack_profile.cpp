@@ -0,0 +1,114 @@
+#include "stack_profile.h"
+
+#include <algorithm>
+#include <cxxabi.h>
+#include <cstdio>
+#include <cstdlib>
+#include <dlfcn.h>
+#include <mutex>
+#include <unordered_map>
+
+#include "task.h"
+
+namespace {
+	struct Site_stats {
+		uint64_t tasks;
+		size_t	 capacity;
+		size_t	 max_used;
+		uint64_t total_used;
+	};
+
+	std::mutex& Mutex() {
+		RCO_STATIC std::mutex s_mutex;
+		return s_mutex;
+	}
+
+	std::unordered_map<const void*, Site_stats>& Sites() {
+		RCO_STATIC std::unordered_map<const void*, Site_stats> s_sites;
+		return s_sites;
+	}
+}
+
+std::string rco::Symbolize(const void* addr) {
+	char buf[32];
+	Dl_info info;
+	if(!addr || !dladdr(addr, &info) || !info.dli_sname) {
+		snprintf(buf, sizeof(buf), "%p", addr);
+		return buf;
+	}
+
+	int status = 0;
+	char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+	std::string name = (status == 0 && demangled) ? demangled : info.dli_sname;
+	free(demangled);
+
+	snprintf(buf, sizeof(buf), "+0x%lx", (unsigned long)((const char*)addr - (const char*)info.dli_saddr));
+	return name + buf;
+}
+
+std::atomic<bool> rco::Stack_profile::enabled(false);
+
+void rco::Stack_profile::Enable(bool on) {
+	enabled = on;
+}
+
+void rco::Stack_profile::Record(const Task& task) {
+	size_t used = task.stack_used();
+	// 协程创建时未开启统计
+	if(!used) {
+		return;
+	}
+
+	std::unique_lock<std::mutex> scope_lock(Mutex());
+	Site_stats& stats = Sites()[task.spawn_site()];
+	++stats.tasks;
+	stats.capacity = task.stack_capacity();
+	stats.max_used = std::max(stats.max_used, used);
+	stats.total_used += used;
+}
+
+std::vector<rco::Stack_site_usage> rco::Stack_profile::Report() {
+	std::vector<Stack_site_usage> report;
+	{
+		std::unique_lock<std::mutex> scope_lock(Mutex());
+		report.reserve(Sites().size());
+		for(auto& it : Sites()) {
+			Stack_site_usage usage;
+			usage.site = it.first;
+			usage.tasks = it.second.tasks;
+			usage.capacity = it.second.capacity;
+			usage.max_used = it.second.max_used;
+			usage.avg_used = it.second.total_used / it.second.tasks;
+			usage.suggested = (usage.max_used + usage.max_used / 4 + 1023) & ~(size_t)1023;
+			report.push_back(std::move(usage));
+		}
+	}
+
+	// 解析符号不需要持有锁
+	for(Stack_site_usage& usage : report) {
+		usage.symbol = Symbolize(usage.site);
+	}
+
+	std::sort(report.begin(), report.end(), [](const Stack_site_usage& a, const Stack_site_usage& b) {
+			return a.max_used > b.max_used;
+			});
+	return report;
+}
+
+void rco::Stack_profile::Dump(std::ostream& os) {
+	os << "stack usage by spawn site (bytes):\n";
+	for(const Stack_site_usage& usage : Report()) {
+		os << "  " << usage.symbol
+		   << " tasks=" << usage.tasks
+		   << " capacity=" << usage.capacity
+		   << " max=" << usage.max_used
+		   << " avg=" << usage.avg_used
+		   << " suggested=" << usage.suggested << "\n";
+	}
+	os.flush();
+}
+
+void rco::Stack_profile::Reset() {
+	std::unique_lock<std::mutex> scope_lock(Mutex());
+	Sites().clear();
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "../common/internal.h"
+
+namespace rco {
+
+	class Task;
+
+	/**
+	 * @brief 将代码地址解析为 函数名+偏移(需要 -rdynamic 导出符号)，无法解析时为地址
+	 *
+	 * @param[in] addr 代码地址
+	 *
+	 * @return 符号
+	 */
+	std::string Symbolize(const void* addr);
+
+	/**
+	 * @brief 按创建位置统计的栈使用量
+	 */
+	struct Stack_site_usage {
+		const void* site;		// 创建协程的代码地址
+		std::string symbol;		// 所在函数(需要 -rdynamic 导出符号)
+		uint64_t	tasks;		// 已回收的协程数
+		size_t		capacity;	// 栈的可用大小(取最近一次)
+		size_t		max_used;	// 栈使用的最大深度
+		size_t		avg_used;	// 栈使用的平均深度
+		size_t		suggested;	// 建议的栈大小：最大深度加 25% 余量，按 1K 对齐
+	};
+
+	/**
+	 * @brief 栈使用量统计
+	 *
+	 * 开启后新建协程的栈在分配时填充标记，协程结束归还栈时测量栈使用的最大深度，
+	 * 按创建位置(rco_go/rco_exec 所在的代码地址)汇总，用于为不同的协程选择栈大小
+	 */
+	class Stack_profile {
+		public:
+			Stack_profile() = delete;
+
+			/**
+			 * @brief 开启/关闭统计，只影响之后创建的协程
+			 *
+			 * @param[in] on 开启 ? true : false
+			 */
+			RCO_STATIC void Enable(bool on);
+
+			RCO_STATIC RCO_INLINE bool Enabled() {
+				return enabled.load(std::memory_order_relaxed);
+			}
+
+			/**
+			 * @brief 记录已结束协程的栈使用量(需在归还栈之前调用)
+			 *
+			 * @param[in] task 协程
+			 */
+			RCO_STATIC void Record(const Task& task);
+
+			/**
+			 * @brief 获取统计结果，按最大深度降序排列
+			 *
+			 * @return 每个创建位置的统计
+			 */
+			RCO_STATIC std::vector<Stack_site_usage> Report();
+
+			/**
+			 * @brief 输出统计结果
+			 *
+			 * @param[in] os 输出流
+			 */
+			RCO_STATIC void Dump(std::ostream& os);
+
+			/**
+			 * @brief 清空统计结果
+			 */
+			RCO_STATIC void Reset();
+
+		private:
+			RCO_STATIC std::atomic<bool> enabled;
+	};
+}
@@ -1,13 +1,25 @@
 #include "task.h"
+
+#include <atomic>
 #include <functional>
 
 rco::Task::Task(const Execute& exec, const Attribute& attr)
 	: Intrusive_queue()
-    , ctx(&Task::DoWork, this, attr.stack_size)
+    , ctx(&Task::DoWork, this, attr.stackless ? 0 : attr.stack_size, attr.stack_mode, attr.max_stack_size, attr.profile_stack)
+	, sched_ctx(nullptr)
 	, execute(std::move(exec))
 	, exec_state(State::eRunnable)
 	  , processor(nullptr)
-	  , unique_id(0){
+	  , unique_id(0)
+	  , site(attr.spawn_site)
+	  , woken_at(0)
+	  , parked_at(0)
+	  , wait_why(nullptr)
+	  , last_run(0)
+	  , async_preempt(attr.preemptible)
+	  , direct_resumable(false)
+	  , no_stack(attr.stackless)
+	  , stack_running(0) {
 
 	  }
 
@@ -16,14 +28,36 @@ rco::Task::~Task() {
 }
 
 void rco::Task::yield() {
-	ctx.swap_out();
+	// 切换过程中不允许被异步抢占
+	stack_running = 0;
+	std::atomic_signal_fence(std::memory_order_seq_cst);
+
+	ctx.swap_out(*sched_ctx);
+
+	direct_resumable = false;
+	std::atomic_signal_fence(std::memory_order_seq_cst);
+	stack_running = 1;
 }
 
-void rco::Task::resume() {
-	ctx.swap_in();
+void rco::Task::transfer(Task* next) {
+	stack_running = 0;
+	std::atomic_signal_fence(std::memory_order_seq_cst);
+
+	// next 挂起时同样切换回当前的调度上下文
+	next->sched_ctx = sched_ctx;
+	ctx.swap_out(next->ctx);
+
+	direct_resumable = false;
+	std::atomic_signal_fence(std::memory_order_seq_cst);
+	stack_running = 1;
 }
 
-void rco::Task::run() {
+void rco::Task::resume(RContext& sched) {
+	sched_ctx = &sched;
+	ctx.swap_in(sched);
+}
+
+void rco::Task::run_inline() {
 	try {
 		execute();
         execute = Execute();
@@ -32,6 +66,13 @@ void rco::Task::run() {
 	}
 
 	exec_state = State::eFinish;
+}
+
+void rco::Task::run() {
+	stack_running = 1;
+	std::atomic_signal_fence(std::memory_order_seq_cst);
+
+	run_inline();
 	yield();
 }
 
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+#include <csignal>
 #include <functional>
 
 #include "../common/internal.h"
@@ -28,10 +30,22 @@ namespace rco {
 			};
 
 			struct Attribute {
-				size_t stack_size;
+				size_t			 stack_size;
+				core::Stack_mode stack_mode;	 // 栈的分配方式
+				size_t			 max_stack_size; // eGrowable 时栈可扩展到的大小
+				bool			 preemptible;	 // 是否允许在信号处理函数中被异步抢占(切出)
+				bool			 stackless;		 // 不会挂起的协程，直接在执行器的调度栈上执行，不分配栈
+				bool			 profile_stack;	 // 是否统计栈使用量(见 Stack_profile)
+				const void*		 spawn_site;	 // 创建协程的代码地址
 
 				Attribute()
-					: stack_size(1024 << 2) {
+					: stack_size(1024 << 2)
+					  , stack_mode(core::Stack_mode::eHeap)
+					  , max_stack_size(1024 << 10)
+					  , preemptible(false)
+					  , stackless(false)
+					  , profile_stack(false)
+					  , spawn_site(nullptr) {
 
 					}
 			};
@@ -40,7 +54,7 @@ namespace rco {
 			 * @brief Task构造函数
 			 *
 			 * @param[in] exec			任务执行实体
-			 * @param[in] stack_size	协程栈大小，默认2K
+			 * @param[in] attr			协程属性(栈大小默认4K)
 			 */
 			Task(const Execute& exec, const Attribute& attr);
 			~Task();
@@ -50,10 +64,95 @@ namespace rco {
 			 */
 			void yield();
 
+			/**
+			 * @brief 协程准备切出：之后不允许被异步抢占，并标记该协程之后可被其他协程直接切入
+			 */
+			RCO_INLINE void prepare_switch() {
+				stack_running = 0;
+				std::atomic_signal_fence(std::memory_order_seq_cst);
+				direct_resumable = true;
+			}
+
+			/**
+			 * @brief 取消切出(没有其他可运行的协程)，恢复prepare_switch之前的状态
+			 */
+			RCO_INLINE void cancel_switch() {
+				direct_resumable = false;
+				std::atomic_signal_fence(std::memory_order_seq_cst);
+				stack_running = 1;
+			}
+
+			/**
+			 * @brief 从该协程直接切换到next，不经过调度上下文
+			 *
+			 * @param[in] next 下一个运行的协程(必须可被直接切入)
+			 */
+			void transfer(Task* next);
+
+			/**
+			 * @brief 在当前栈上执行协程函数，返回时协程已结束(无栈协程在执行器的调度栈上调用)
+			 */
+			void run_inline();
+
 			/**
 			 * @brief 协程恢复
+			 *
+			 * @param[in] sched 执行器的调度上下文，协程挂起时切换回该上下文
+			 */
+			void resume(RContext& sched);
+
+			/**
+			 * @brief 处理协程栈的访问异常(在 SIGSEGV 处理函数中调用)
+			 *
+			 * @param[in] addr 异常地址
+			 *
+			 * @return 处理结果
+			 */
+			RCO_INLINE core::Stack_fault stack_fault(void* addr) {
+				return ctx.fault(addr);
+			}
+
+			/**
+			 * @brief 协程的栈是否已分配
+			 */
+			RCO_INLINE bool stack_ready() const {
+				return ctx.ready();
+			}
+
+			/**
+			 * @brief 分配协程栈(第一次切入前)
+			 *
+			 * @param[in] cache 执行器的栈缓存
+			 */
+			RCO_INLINE void acquire_stack(core::Stack_cache* cache) {
+				ctx.acquire(cache);
+			}
+
+			/**
+			 * @brief 归还协程栈(协程结束后)
+			 *
+			 * @param[in] cache 执行器的栈缓存
+			 */
+			RCO_INLINE void release_stack(core::Stack_cache* cache) {
+				ctx.release(cache);
+			}
+
+			/**
+			 * @brief 栈使用的最大深度，未统计栈使用量时为0
+			 *
+			 * @return 字节数
 			 */
-			void resume();
+			RCO_INLINE size_t stack_used() const {
+				return ctx.stack_used();
+			}
+
+			RCO_INLINE size_t stack_capacity() const {
+				return ctx.stack_capacity();
+			}
+
+			RCO_INLINE const void* spawn_site() const {
+				return site;
+			}
 
 			RCO_INLINE void set_id(uint64_t id) {
 				unique_id = id;
@@ -71,6 +170,74 @@ namespace rco {
 				return exec_state;
 			}
 
+			/**
+			 * @brief 记录被唤醒的时刻(用于统计唤醒延迟)
+			 *
+			 * @param[in] ns 单调时钟(纳秒)，0 表示不统计
+			 */
+			RCO_INLINE void set_wake_time(uint64_t ns) {
+				woken_at = ns;
+			}
+
+			RCO_INLINE uint64_t wake_time() const {
+				return woken_at;
+			}
+
+			/**
+			 * @brief 记录挂起的时刻(用于统计挂起时长)
+			 *
+			 * @param[in] ns 单调时钟(纳秒)，0 表示不统计
+			 */
+			RCO_INLINE void set_park_time(uint64_t ns) {
+				parked_at = ns;
+			}
+
+			RCO_INLINE uint64_t park_time() const {
+				return parked_at;
+			}
+
+			/**
+			 * @brief 设置挂起原因(CoPark)
+			 *
+			 * @param[in] reason 原因，须为静态字符串
+			 */
+			RCO_INLINE void set_wait_reason(const char* reason) {
+				wait_why = reason;
+			}
+
+			RCO_INLINE const char* wait_reason() const {
+				return wait_why;
+			}
+
+			/**
+			 * @brief 记录最近一次切出(或创建)的调度时刻
+			 *
+			 * @param[in] tick 调度时刻(微秒)
+			 */
+			RCO_INLINE void set_last_run(uint64_t tick) {
+				last_run = tick;
+			}
+
+			RCO_INLINE uint64_t last_run_tick() const {
+				return last_run;
+			}
+
+			/**
+			 * @brief 回溯已切出的协程的调用栈
+			 *
+			 * @param[out] frames 返回地址，由内向外
+			 * @param[in]  max	  最多回溯的层数
+			 *
+			 * @return 层数
+			 */
+			RCO_INLINE size_t backtrace(void** frames, size_t max) const {
+				return ctx.backtrace(frames, max);
+			}
+
+			RCO_INLINE bool stack_range(uintptr_t& low, uintptr_t& high) const {
+				return ctx.stack_range(low, high);
+			}
+
 			RCO_INLINE void set_own_proc(Processor* proc) {
 				processor = proc;
 			}
@@ -79,15 +246,66 @@ namespace rco {
 				return processor;
 			}
 
+			/**
+			 * @brief 是否允许异步抢占
+			 *
+			 * 异步抢占会在任意指令处将协程切出，协程不能持有锁、不能分配内存，
+			 * 只适用于纯计算的协程；其余协程只在安全点(Runtime::Preempt_point)被抢占
+			 */
+			RCO_INLINE bool preemptible() const {
+				return async_preempt;
+			}
+
+			/**
+			 * @brief 是否为无栈协程
+			 *
+			 * 无栈协程(rco_stackless)在调度栈上运行到结束，不能切出：CoYield 与 CoPark 抛出 std::logic_error
+			 * (不会退回到分配真正的栈继续执行)；blocking 在执行器线程中直接执行
+			 */
+			RCO_INLINE bool stackless() const {
+				return no_stack;
+			}
+
+			/**
+			 * @brief 是否可被其他协程直接切入
+			 *
+			 * 只有在CoYield/CoPark中切出的协程可以，新协程与在信号处理函数中被抢占的协程需要经过调度上下文
+			 *
+			 * @return 是 ? true : false
+			 */
+			RCO_INLINE bool resumable_directly() const {
+				return direct_resumable;
+			}
+
+			/**
+			 * @brief 当前线程是否运行在该协程的栈上(不包括上下文切换的过程)
+			 *
+			 * @return 是 ? true : false
+			 */
+			RCO_INLINE bool on_stack() const {
+				return stack_running;
+			}
+
 			State	   exec_state;
 		private:
 			void run();
 			RCO_STATIC void DoWork(void *arg);
 
 			RContext   ctx;
+			RContext  *sched_ctx;	// 所在执行器的调度上下文
 			Execute	   execute;
 			Processor *processor;
 			Switcher  *switcher;
 			uint64_t   unique_id;
+			const void* site;		// 创建协程的代码地址
+			uint64_t   woken_at;	// 被唤醒的时刻(纳秒)
+			uint64_t   parked_at;	// 挂起的时刻(纳秒)
+			const char* wait_why;	// 挂起原因
+			uint64_t   last_run;	// 最近一次切出(或创建)的调度时刻(微秒)
+			bool	   async_preempt;
+			bool	   direct_resumable;
+			bool	   no_stack;		// 无栈协程
+
+			volatile sig_atomic_t stack_running;
 	};
 }
@@ -0,0 +1,74 @@
+//
+// 批量创建：每个下标恰好执行一次、关闭后整批拒绝、与关闭并发时整批执行或整批拒绝
+//
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "rco.h"
+#include "tests/test.h"
+
+namespace {
+
+	/**
+	 * @brief 第 i 个协程执行 execute(i)，每个下标恰好一次
+	 */
+	void Test_indices() {
+		rco::Scheduler* sched = rco::Scheduler::Make();
+		sched->start(4, 4, true);
+
+		const std::size_t count = 10000;
+		std::unique_ptr<std::atomic<int>[]> hits(new std::atomic<int>[count]);
+		for(std::size_t i = 0; i < count; ++i) {
+			hits[i] = 0;
+		}
+
+		RCO_CHECK(sched->make_tasks(count, [&hits](std::size_t i){ ++hits[i]; }, rco::Task::Attribute()));
+		RCO_CHECK(sched->make_tasks(0, [](std::size_t){}, rco::Task::Attribute()));
+
+		RCO_CHECK(sched->shutdown(std::chrono::seconds(10)));
+		for(std::size_t i = 0; i < count; ++i) {
+			RCO_CHECK(hits[i] == 1);
+		}
+		RCO_CHECK(sched->stats().tasks_unfinished == 0);
+
+		// 关闭后整批被拒绝
+		RCO_CHECK(!sched->make_tasks(10, [&hits](std::size_t i){ ++hits[i]; }, rco::Task::Attribute()));
+		RCO_CHECK(hits[0] == 1);
+	}
+
+	/**
+	 * @brief 与关闭并发批量创建：在 accepting 翻转时创建的批次要么整批执行，要么整批被拒绝
+	 */
+	void Test_spawn_race() {
+		const int batch = 16;
+		// 每个被接受的批次各自计数(只在创建线程中追加，关闭并 join 后检查)
+		std::vector<std::shared_ptr<std::atomic<int> > > batches;
+		int ran = rco_test::Check_spawn_race([&batches, batch](rco::Scheduler* sched, std::atomic<int>& ran) {
+				std::shared_ptr<std::atomic<int> > count(new std::atomic<int>(0));
+				bool accepted = sched->make_tasks(batch, [&ran, count](std::size_t){
+						++*count;
+						++ran;
+						}, rco::Task::Attribute());
+				if(!accepted) {
+					return 0;
+				}
+				batches.push_back(count);
+				return batch;
+				});
+
+		RCO_CHECK(ran % batch == 0);
+		RCO_CHECK(ran == (int)batches.size() * batch);
+		for(const std::shared_ptr<std::atomic<int> >& count : batches) {
+			RCO_CHECK(*count == batch);
+		}
+	}
+}
+
+int main() {
+	Test_indices();
+	Test_spawn_race();
+	return 0;
+}
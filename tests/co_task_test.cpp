@@ -0,0 +1,92 @@
+//
+// co_task(需要 C++20)：co_await 链、co_wait、co_blocking 与关闭排空
+//
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+#include "rco.h"
+#include "tests/test.h"
+
+namespace {
+
+	rco::co_task<int> Square(int n) {
+		co_await rco::co_yield_now();
+		co_return n * n;
+	}
+
+	rco::co_task<int> Sum_squares(int n) {
+		int sum = 0;
+		for(int i = 1; i <= n; ++i) {
+			sum += co_await Square(i);
+		}
+		co_return sum;
+	}
+
+	/**
+	 * @brief co_await 链的结果，在线程与有栈协程中通过 co_wait 取得
+	 */
+	void Test_wait() {
+		rco::Scheduler* sched = rco::Scheduler::Make();
+		sched->start(2, 2, true);
+
+		RCO_CHECK(rco::co_wait(Sum_squares(10), sched) == 385);
+
+		std::atomic<int> result(0);
+		rco_go - rco_scheduler(sched) + [&result]{
+			result = rco::co_wait(Square(12));
+		};
+
+		RCO_CHECK(sched->shutdown(std::chrono::seconds(10)));
+		RCO_CHECK(result == 144);
+	}
+
+	std::atomic<int> blocking_result(0);
+	std::atomic<int> resumed_on_proc(0);
+
+	rco::co_task<void> Slow_blocking(rco::Scheduler* sched) {
+		int value = co_await rco::co_blocking([]{
+				std::this_thread::sleep_for(std::chrono::milliseconds(200));
+				return 7;
+				});
+		// 阻塞调用结束后回到本调度器的执行器上恢复，而不是在线程池线程上
+		rco::Processor* proc = rco::Processor::CurrentProcessor();
+		if(proc && proc->belong_scheduler() == sched) {
+			++resumed_on_proc;
+		}
+		blocking_result = value;
+	}
+
+	/**
+	 * @brief 关闭等待挂起在 co_blocking 上的 co_task 执行完毕，之后拒绝 co_spawn
+	 */
+	void Test_blocking_drain() {
+		rco::Scheduler* sched = rco::Scheduler::Make();
+		sched->start(1, 1, true);
+
+		RCO_CHECK(rco::co_spawn(Slow_blocking(sched), sched));
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+		RCO_CHECK(sched->shutdown(std::chrono::seconds(10)));
+		RCO_CHECK(blocking_result == 7);
+		RCO_CHECK(resumed_on_proc == 1);
+		RCO_CHECK(sched->stats().tasks_unfinished == 0);
+
+		RCO_CHECK(!rco::co_spawn(Slow_blocking(sched), sched));
+		bool thrown = false;
+		try {
+			rco::co_wait(Square(2), sched);
+		} catch(const std::logic_error&) {
+			thrown = true;
+		}
+		RCO_CHECK(thrown);
+	}
+}
+
+int main() {
+	Test_wait();
+	Test_blocking_drain();
+	return 0;
+}
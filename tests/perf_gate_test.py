@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+# tools/perf/perf_gate.py 的比较逻辑：基准名匹配、缺失的基准、吞吐与延迟容差
+
+import os
+import sys
+import unittest
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "tools", "perf"))
+
+import perf_gate  # noqa: E402
+
+
+def statuses(rows):
+    return {(row[1], row[2]): row[6] for row in rows}
+
+
+class CompareTest(unittest.TestCase):
+
+    def test_iterations_suffix_ignored(self):
+        baseline = {"rco_bench": {"BM_spawn/iterations:10": {"items_per_second": 100.0}}}
+        current = {"rco_bench": {"BM_spawn/iterations:20": {"items_per_second": 98.0}}}
+        rows, regressed = perf_gate.compare(baseline, current, 10.0, 25.0)
+        self.assertFalse(regressed)
+        self.assertEqual(statuses(rows), {("BM_spawn", "items_per_second"): "ok"})
+
+    def test_throughput_regression(self):
+        baseline = {"rco_bench": {"BM_spawn": {"items_per_second": 100.0}}}
+        current = {"rco_bench": {"BM_spawn": {"items_per_second": 80.0}}}
+        rows, regressed = perf_gate.compare(baseline, current, 10.0, 25.0)
+        self.assertTrue(regressed)
+        self.assertEqual(statuses(rows)[("BM_spawn", "items_per_second")], "REGRESSED")
+
+    def test_missing_benchmark_fails(self):
+        baseline = {"rco_bench": {"BM_spawn": {"items_per_second": 100.0},
+                                  "BM_yield": {"items_per_second": 100.0}}}
+        current = {"rco_bench": {"BM_spawn": {"items_per_second": 100.0}}}
+        rows, regressed = perf_gate.compare(baseline, current, 10.0, 25.0)
+        self.assertTrue(regressed)
+        self.assertEqual(statuses(rows)[("BM_yield", "-")], "MISSING")
+
+    def test_new_benchmark_passes(self):
+        baseline = {"rco_bench": {}}
+        current = {"rco_bench": {"BM_spawn": {"items_per_second": 100.0}}}
+        rows, regressed = perf_gate.compare(baseline, current, 10.0, 25.0)
+        self.assertFalse(regressed)
+        self.assertEqual(statuses(rows)[("BM_spawn", "-")], "new")
+
+    def test_latency_uses_own_tolerance(self):
+        baseline = {"rco_macro_bench": {"ring/threads:1": {"p50_us": 1.0, "p99_us": 2.0}}}
+        current = {"rco_macro_bench": {"ring/threads:1": {"p50_us": 1.2, "p99_us": 2.6}}}
+        rows, regressed = perf_gate.compare(baseline, current, 10.0, 25.0)
+        self.assertTrue(regressed)
+        result = statuses(rows)
+        self.assertEqual(result[("ring/threads:1", "p50_us")], "ok")
+        self.assertEqual(result[("ring/threads:1", "p99_us")], "REGRESSED")
+
+    def test_ungated_metrics_ignored(self):
+        # p999 与 skynet 的每轮统计只报告不比较
+        baseline = {"rco_macro_bench": {"skynet/threads:1": {"mean_us": 10.0, "p999_us": 1.0}}}
+        current = {"rco_macro_bench": {"skynet/threads:1": {"mean_us": 50.0, "p999_us": 9.0}}}
+        rows, regressed = perf_gate.compare(baseline, current, 10.0, 25.0)
+        self.assertFalse(regressed)
+        self.assertEqual(rows, [])
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,75 @@
+//
+// 关闭过程：排空等待协程执行完毕、关闭后拒绝外部创建、超时取消、与并发创建的竞争
+//
+
+#include <atomic>
+#include <chrono>
+
+#include "rco.h"
+#include "tests/test.h"
+
+namespace {
+
+	/**
+	 * @brief 关闭等待已创建的协程(包括它们在关闭期间创建的协程)执行完毕
+	 */
+	void Test_drain() {
+		rco::Scheduler* sched = rco::Scheduler::Make();
+		sched->start(2, 2, true);
+
+		std::atomic<int> done(0);
+		for(int i = 0; i < 100; ++i) {
+			rco_go - rco_scheduler(sched) + [sched, &done]{
+				rco::Processor::CoYield();
+				// 关闭期间调度器内的协程仍可以创建协程
+				RCO_CHECK(rco_go - rco_scheduler(sched) + [&done]{ ++done; });
+				++done;
+			};
+		}
+
+		RCO_CHECK(sched->shutdown(std::chrono::seconds(10)));
+		RCO_CHECK(done == 200);
+		RCO_CHECK(sched->stats().tasks_unfinished == 0);
+
+		// 关闭后外部创建的协程被拒绝
+		RCO_CHECK(!(rco_go - rco_scheduler(sched) + [&done]{ ++done; }));
+		RCO_CHECK(done == 200);
+	}
+
+	/**
+	 * @brief 超时后取消剩余的协程，未完成的协程数归零
+	 */
+	void Test_timeout() {
+		rco::Scheduler* sched = rco::Scheduler::Make();
+		sched->start(1, 1, true);
+
+		std::atomic<bool> release(false);
+		for(int i = 0; i < 10; ++i) {
+			rco_go - rco_scheduler(sched) + [&release]{
+				while(!release) {
+					rco::Processor::CoYield();
+				}
+			};
+		}
+
+		RCO_CHECK(!sched->shutdown(std::chrono::milliseconds(20)));
+		RCO_CHECK(sched->stats().tasks_unfinished == 0);
+		release = true;
+	}
+
+	/**
+	 * @brief 与关闭并发创建：每个被接受的协程都被执行，被拒绝的不计入
+	 */
+	void Test_spawn_race() {
+		rco_test::Check_spawn_race([](rco::Scheduler* sched, std::atomic<int>& ran) {
+				return (rco_go - rco_scheduler(sched) + [&ran]{ ++ran; }) ? 1 : 0;
+				});
+	}
+}
+
+int main() {
+	Test_drain();
+	Test_timeout();
+	Test_spawn_race();
+	return 0;
+}
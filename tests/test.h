@@ -0,0 +1,62 @@
+//
+// 行为测试的公共检查宏与辅助函数：失败时输出位置与条件并以非零退出码结束(由 ctest 判定)
+//
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+#include "rco.h"
+
+#define RCO_CHECK(cond)																	\
+	do {																				\
+		if(!(cond)) {																	\
+			std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);	\
+			std::exit(1);																\
+		}																				\
+	} while(0)
+
+namespace rco_test {
+
+	/**
+	 * @brief 在另一个线程中不断创建协程的同时关闭调度器，检查关闭成功、被接受的协程全部执行、
+	 *		  未完成的协程数归零
+	 *
+	 * @param[in] spawn	 spawn(sched, ran)：创建协程，协程执行时递增 ran，返回被接受的协程数
+	 * @param[in] rounds 重复次数
+	 *
+	 * @return 各轮执行的协程数之和
+	 */
+	template <typename Spawn>
+		int Check_spawn_race(Spawn spawn, int rounds = 10) {
+			int total = 0;
+			for(int round = 0; round < rounds; ++round) {
+				rco::Scheduler* sched = rco::Scheduler::Make();
+				sched->start(2, 2, true);
+
+				std::atomic<int> accepted(0);
+				std::atomic<int> ran(0);
+				std::atomic<bool> stop(false);
+				std::thread spawner([&]{
+					while(!stop) {
+						accepted += spawn(sched, ran);
+					}
+				});
+
+				std::this_thread::sleep_for(std::chrono::milliseconds(5));
+				bool ok = sched->shutdown(std::chrono::seconds(10));
+				stop = true;
+				spawner.join();
+
+				RCO_CHECK(ok);
+				RCO_CHECK(accepted == ran);
+				RCO_CHECK(sched->stats().tasks_unfinished == 0);
+				total += ran;
+			}
+			return total;
+		}
+}
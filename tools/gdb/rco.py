@@ -0,0 +1,157 @@
+# librco 的 gdb 辅助命令，可用于运行中的进程与 core 文件
+#
+# 加载:
+#   (gdb) source tools/gdb/rco.py
+#
+# 命令:
+#   rco-tasks [调度器表达式]      列出所有存活协程(位置、挂起原因、空闲时间、创建位置与调用栈)
+#                                默认为 rco::Scheduler::Instance() 的单例，其他调度器传入 Scheduler* 表达式
+#
+# 调用栈从协程切出时保存的寄存器开始沿帧指针回溯，需要以 -fno-omit-frame-pointer 编译，
+# 目前只支持汇编上下文后端(RCO_CONTEXT_BACKEND=asm)在 x86_64/aarch64 上的寄存器布局
+
+import gdb
+
+DEFAULT_SCHEDULER = "'rco::Scheduler::Instance()::s_sched'"
+MAX_FRAMES = 32
+
+# core/details/context.cpp 中切出后栈上保存的寄存器位置: (帧指针, 返回地址)
+SAVED_SLOTS = {
+    "x86-64": (6, 7),
+    "aarch64": (18, 19),
+}
+
+
+def _arch_slots():
+    name = gdb.selected_inferior().architecture().name()
+    for key, slots in SAVED_SLOTS.items():
+        if key in name:
+            return slots
+    return None
+
+
+def _read_ptr(addr):
+    ptr_size = gdb.lookup_type("void").pointer().sizeof
+    data = gdb.selected_inferior().read_memory(addr, ptr_size)
+    return int.from_bytes(bytes(data), "little")
+
+
+def _vector_items(vec):
+    start = vec["_M_impl"]["_M_start"]
+    finish = vec["_M_impl"]["_M_finish"]
+    return [start[i] for i in range(int(finish - start))]
+
+
+def _task_offset():
+    # Task 中 Intrusive_queue 基类的偏移
+    return int(gdb.parse_and_eval(
+        "(long)(rco::Intrusive_queue*)(rco::Task*)4096 - 4096"))
+
+
+def _queue_tasks(queue, offset):
+    task_ptr = gdb.lookup_type("rco::Task").pointer()
+    node = queue["head"]["next"]
+    while int(node):
+        yield gdb.Value(int(node) - offset).cast(task_ptr)
+        node = node["next"]
+
+
+def _symbolize(pc):
+    if not pc:
+        return "0x0"
+    # 返回地址指向调用的下一条指令，取前一个字节所在的函数与行
+    block = None
+    try:
+        block = gdb.block_for_pc(pc - 1)
+    except RuntimeError:
+        pass
+    while block is not None and block.function is None:
+        block = block.superblock
+    name = block.function.print_name if block is not None else None
+    if name is None:
+        sym = gdb.execute("info symbol 0x%x" % pc, to_string=True).strip()
+        name = sym.split(" in section")[0] if not sym.startswith("No symbol") else "0x%x" % pc
+    sal = gdb.find_pc_line(pc - 1)
+    if sal.symtab is not None:
+        return "%s at %s:%d" % (name, sal.symtab.filename, sal.line)
+    return name
+
+
+def _backtrace(task):
+    slots = _arch_slots()
+    rctx = task["ctx"]
+    ctx = rctx["ctx"]
+    sp = int(ctx["sp"])
+    if slots is None or not sp or not int(rctx["stack"]["base"]):
+        return []
+
+    low = sp
+    high = int(ctx["stack_ptr"]) + int(ctx["stack_size"])
+    ptr_size = gdb.lookup_type("void").pointer().sizeof
+
+    fp = _read_ptr(sp + slots[0] * ptr_size)
+    frames = [_read_ptr(sp + slots[1] * ptr_size)]
+    while len(frames) < MAX_FRAMES:
+        # 帧必须在栈内、对齐，并且逐层向栈底方向移动
+        if fp < low or fp + 2 * ptr_size > high or fp % ptr_size:
+            break
+        ret = _read_ptr(fp + ptr_size)
+        if not ret:
+            break
+        frames.append(ret)
+        low = fp + 2 * ptr_size
+        fp = _read_ptr(fp)
+    return frames
+
+
+def _task_name(task_id):
+    return "%d:%d" % (task_id >> 48, task_id & ((1 << 48) - 1))
+
+
+class RcoTasks(gdb.Command):
+    """列出 librco 调度器中所有存活的协程: rco-tasks [Scheduler* 表达式]"""
+
+    def __init__(self):
+        super(RcoTasks, self).__init__("rco-tasks", gdb.COMMAND_DATA)
+
+    def invoke(self, arg, from_tty):
+        expr = arg.strip()
+        sched = gdb.parse_and_eval(expr) if expr else gdb.parse_and_eval(DEFAULT_SCHEDULER)
+        if sched.type.strip_typedefs().code == gdb.TYPE_CODE_PTR:
+            sched = sched.dereference()
+
+        tick = int(sched["tick"])
+        offset = _task_offset()
+        total = 0
+
+        print("rco: scheduler %d" % int(sched["sched_id"]))
+        for proc in _vector_items(sched["processors"]):
+            proc = proc.dereference()
+            running = int(proc["running_task"])
+            print("processor %d:" % int(proc["thread_id"]))
+
+            queues = (("runnable", proc["runnable_queue"]),
+                      ("waiting", proc["wait_queue"]),
+                      ("ready", proc["ready_queue"]))
+            for where, queue in queues:
+                for task in _queue_tasks(queue, offset):
+                    total += 1
+                    is_running = int(task) == running and where == "runnable"
+                    line = "  task %s %s" % (_task_name(int(task["unique_id"])),
+                                             "running" if is_running else where)
+                    if where == "waiting":
+                        reason = task["wait_why"]
+                        line += " (%s)" % (reason.string() if int(reason) else "park")
+                    last_run = int(task["last_run"])
+                    idle = tick - last_run if tick > last_run else 0
+                    line += " idle=%dms spawned at %s" % (idle // 1000, _symbolize(int(task["site"])))
+                    print(line)
+
+                    if is_running:
+                        continue
+                    for i, pc in enumerate(_backtrace(task)):
+                        print("      #%d %s" % (i, _symbolize(pc)))
+        print("rco: %d live tasks" % total)
+
+
+RcoTasks()
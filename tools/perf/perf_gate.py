@@ -0,0 +1,216 @@
+#!/usr/bin/env python3
+# librco 性能回归门禁：运行基准，与保存的基线比较，超出容差时失败并输出差异报告
+#
+# 用法:
+#   tools/perf/perf_gate.py --build-dir build --update      运行并保存为基线
+#   tools/perf/perf_gate.py --build-dir build               运行并与基线比较，回归时退出码为 1
+#
+# 基准:
+#   rco_bench        Google Benchmark 微基准，通过 RCO_BENCH_ITERATIONS 固定迭代次数，
+#                    重复多次取中位数，比较 items_per_second(没有时比较 real_time)
+#   rco_macro_bench  宏基准，比较 items_per_second 与 p50/p99 延迟(只有 ring、echo 这样
+#                    有真实样本分布的基准才输出分位数；p999 样本太少，只报告不比较)
+#
+# 基准名中的 /iterations:N 会被去掉，修改 --iterations 不会改变基准名；
+# 基线中有而本次没有的基准视为回归。延迟噪声大于吞吐，使用单独且更宽的容差
+#
+# 运行时通过 taskset 绑定到 --cpus 指定的核心(宏基准的最大执行器数为绑定的核心数)，
+# 基线只在相同机器、相同绑定下有意义
+
+import argparse
+import json
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+# 指标: 名称 -> 越大越好
+METRICS = {
+    "items_per_second": True,
+    "real_time": False,
+    "p50_us": False,
+    "p99_us": False,
+}
+
+ITERATIONS_SUFFIX = re.compile(r"/iterations:\d+")
+
+
+def bench_key(name):
+    """用于匹配的基准名：去掉随 --iterations 变化的 /iterations:N"""
+    return ITERATIONS_SUFFIX.sub("", name)
+
+
+def parse_cpus(spec):
+    cpus = []
+    for part in spec.split(","):
+        if "-" in part:
+            begin, end = part.split("-")
+            cpus.extend(range(int(begin), int(end) + 1))
+        elif part:
+            cpus.append(int(part))
+    return cpus
+
+
+def run(cmd, cpus, env=None):
+    if cpus:
+        cmd = ["taskset", "-c", ",".join(str(c) for c in cpus)] + cmd
+    print("perf: " + " ".join(cmd), flush=True)
+    subprocess.check_call(cmd, env=env, stdout=sys.stderr)
+
+
+def run_micro(args, cpus, out):
+    """运行 rco_bench，返回 {基准名: {指标: 值}}(重复的中位数)"""
+    env = dict(os.environ)
+    env["RCO_BENCH_ITERATIONS"] = str(args.iterations)
+    cmd = [os.path.join(args.build_dir, "rco_bench"),
+           "--benchmark_repetitions=%d" % args.repetitions,
+           "--benchmark_report_aggregates_only=true",
+           "--benchmark_out=" + out,
+           "--benchmark_out_format=json"]
+    if args.filter:
+        cmd.append("--benchmark_filter=" + args.filter)
+    run(cmd, cpus, env)
+
+    with open(out) as f:
+        report = json.load(f)
+    results = {}
+    for bench in report["benchmarks"]:
+        # 只有一次重复时没有聚合结果
+        if args.repetitions > 1 and bench.get("aggregate_name") != "median":
+            continue
+        name = bench_key(bench.get("run_name", bench["name"]))
+        metrics = {}
+        if "items_per_second" in bench:
+            metrics["items_per_second"] = bench["items_per_second"]
+        else:
+            metrics["real_time"] = bench["real_time"]
+        results[name] = metrics
+    return results
+
+
+def run_macro(args, cpus, out):
+    """运行 rco_macro_bench，返回 {基准名: {指标: 值}}"""
+    cmd = [os.path.join(args.build_dir, "rco_macro_bench"),
+           "--runs=%d" % args.repetitions,
+           "--json=" + out]
+    if cpus:
+        cmd.append("--max-threads=%d" % len(cpus))
+    cmd.extend(args.macro_args)
+    run(cmd, cpus)
+
+    with open(out) as f:
+        report = json.load(f)
+    return {bench["name"]: {m: bench[m] for m in METRICS if m in bench}
+            for bench in report["benchmarks"]}
+
+
+def compare(baseline, current, tolerance, latency_tolerance):
+    """返回 (报告行, 是否回归)"""
+    rows = []
+    regressed = False
+    for suite in sorted(set(baseline) | set(current)):
+        # 旧基线中的名字可能还带着 /iterations:N
+        base_suite = {bench_key(n): m for n, m in baseline.get(suite, {}).items()}
+        cur_suite = {bench_key(n): m for n, m in current.get(suite, {}).items()}
+        for name in sorted(set(base_suite) | set(cur_suite)):
+            if name not in cur_suite:
+                rows.append((suite, name, "-", "-", "-", "-", "MISSING"))
+                regressed = True
+                continue
+            if name not in base_suite:
+                rows.append((suite, name, "-", "-", "-", "-", "new"))
+                continue
+            for metric, value in sorted(cur_suite[name].items()):
+                if metric not in METRICS:
+                    continue
+                base = base_suite[name].get(metric)
+                if base is None or base == 0:
+                    rows.append((suite, name, metric, "-", "%.4g" % value, "-", "new"))
+                    continue
+
+                change = (value - base) / base * 100.0
+                higher_better = METRICS.get(metric, False)
+                limit = latency_tolerance if metric.startswith("p") else tolerance
+                worse = -change if higher_better else change
+                if worse > limit:
+                    status = "REGRESSED"
+                    regressed = True
+                elif worse < -limit:
+                    status = "improved"
+                else:
+                    status = "ok"
+                rows.append((suite, name, metric, "%.4g" % base, "%.4g" % value,
+                             "%+.1f%%" % change, status))
+    return rows, regressed
+
+
+def format_report(rows, tolerance, latency_tolerance):
+    header = ("suite", "benchmark", "metric", "baseline", "current", "change", "status")
+    widths = [max(len(str(r[i])) for r in rows + [header]) for i in range(len(header))]
+    lines = ["librco perf gate (throughput tolerance %.1f%%, latency tolerance %.1f%%)"
+             % (tolerance, latency_tolerance)]
+    for row in [header] + rows:
+        lines.append("  ".join(str(c).ljust(w) for c, w in zip(row, widths)).rstrip())
+    return "\n".join(lines) + "\n"
+
+
+def main():
+    parser = argparse.ArgumentParser(description="librco performance regression gate")
+    parser.add_argument("--build-dir", default="build", help="包含基准可执行文件的构建目录")
+    parser.add_argument("--baseline", help="基线文件，默认为 <build-dir>/perf_baseline.json")
+    parser.add_argument("--update", action="store_true", help="保存本次结果为基线，不做比较")
+    parser.add_argument("--tolerance", type=float, default=10.0, help="吞吐允许下降的百分比")
+    parser.add_argument("--latency-tolerance", type=float, default=25.0, help="p50/p99 延迟允许上升的百分比")
+    parser.add_argument("--cpus", default="", help="绑定的核心，如 2-5 或 2,4；为空时不绑定")
+    parser.add_argument("--iterations", type=int, default=10, help="rco_bench 每个基准固定的迭代次数")
+    parser.add_argument("--repetitions", type=int, default=3, help="重复次数(取中位数)")
+    parser.add_argument("--filter", default="", help="rco_bench 的 --benchmark_filter")
+    parser.add_argument("--suites", default="rco_bench,rco_macro_bench", help="运行的基准")
+    parser.add_argument("--report", help="差异报告输出文件")
+    parser.add_argument("macro_args", nargs="*", help="传给 rco_macro_bench 的参数(放在 -- 之后)")
+    args = parser.parse_args()
+
+    baseline_path = args.baseline or os.path.join(args.build_dir, "perf_baseline.json")
+    cpus = parse_cpus(args.cpus)
+    suites = [s for s in args.suites.split(",") if s]
+
+    current = {}
+    with tempfile.TemporaryDirectory() as tmp:
+        if "rco_bench" in suites:
+            current["rco_bench"] = run_micro(args, cpus, os.path.join(tmp, "rco_bench.json"))
+        if "rco_macro_bench" in suites:
+            current["rco_macro_bench"] = run_macro(args, cpus, os.path.join(tmp, "rco_macro_bench.json"))
+
+    if args.update:
+        with open(baseline_path, "w") as f:
+            json.dump(current, f, indent=2, sort_keys=True)
+        print("perf: baseline saved to %s" % baseline_path)
+        return 0
+
+    if not os.path.exists(baseline_path):
+        print("perf: no baseline at %s, run with --update first" % baseline_path, file=sys.stderr)
+        return 2
+    with open(baseline_path) as f:
+        baseline = json.load(f)
+    # 只比较本次运行的基准
+    baseline = {suite: results for suite, results in baseline.items() if suite in current}
+    if args.filter and "rco_bench" in baseline:
+        # --filter 没有选中的基准不算缺失
+        pattern = re.compile(args.filter)
+        baseline["rco_bench"] = {name: metrics for name, metrics in baseline["rco_bench"].items()
+                                 if pattern.search(name)}
+
+    rows, regressed = compare(baseline, current, args.tolerance, args.latency_tolerance)
+    report = format_report(rows, args.tolerance, args.latency_tolerance)
+    sys.stdout.write(report)
+    if args.report:
+        with open(args.report, "w") as f:
+            f.write(report)
+
+    print("perf: %s" % ("REGRESSED" if regressed else "ok"))
+    return 1 if regressed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())